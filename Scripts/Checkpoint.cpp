@@ -4,59 +4,159 @@
 #include "Checkpoint/Checkpoint.h"
 
 #include "GP3GameInstance.h"
+#include "GP3Log.h"
+#include "GP3Stats.h"
+#include "GP3ReplaySubsystem.h"
 #include "Characters/PlayerCharacter.h"
 #include "Components/BoxComponent.h"
 #include "GameMode/GP3GameModeBase.h"
 #include "Kismet/GameplayStatics.h"
+#include "Components/WorldPartitionStreamingSourceComponent.h"
+#include "Engine/LevelBounds.h"
+#include "Engine/LevelStreaming.h"
+
+DECLARE_CYCLE_STAT(TEXT("Checkpoint Overlap"), STAT_GP3_CheckpointOverlap, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Checkpoint Overlaps Per Frame"), STAT_GP3_CheckpointOverlaps, STATGROUP_GP3Gameplay);
 
 
 // Sets default values
 ACheckpoint::ACheckpoint()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Checkpoints only react to overlaps
+	PrimaryActorTick.bCanEverTick = false;
 	
 	// Set up the box trigger for player overlap
 	TriggerBoxComponent = CreateDefaultSubobject<UBoxComponent>(TEXT("TriggerBox"));
 	RootComponent = TriggerBoxComponent;
+	// only pawns overlap, the handler then drops everything that isn't player controlled;
+	// a profile set on the instance or a Blueprint still wins over this default
+	TriggerBoxComponent->SetCollisionProfileName(FName(TEXT("OverlapOnlyPawn")));
 
 	// Bind the overlap event
 	TriggerBoxComponent->OnComponentBeginOverlap.AddDynamic(this, &ACheckpoint::OnBoxTriggerBeginOverlap);
 
+	StreamingSource = CreateDefaultSubobject<UWorldPartitionStreamingSourceComponent>(TEXT("StreamingSource"));
+	StreamingSource->DisableStreamingSource();
+
 }
 
 // Called when the game starts or when spawned
 void ACheckpoint::BeginPlay()
 {
 	Super::BeginPlay();
-	
-}
 
-// Called every frame
-void ACheckpoint::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
+	GameInstance = Cast<UGP3GameInstance>(GetGameInstance());
 
+	// the save may have resolved to this checkpoint before it was streamed in
+	if (GameInstance && GameInstance->GetCurrentCheckpointId() == GetCheckpointId())
+	{
+		GameInstance->SetStreamingCheckpoint(this);
+	}
 }
 
 void ACheckpoint::OnBoxTriggerBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
 	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_CheckpointOverlap);
+	INC_DWORD_STAT(STAT_GP3_CheckpointOverlaps);
+
 	APawn* PlayerPawn = Cast<APawn>(OtherActor);
 
-	if (PlayerPawn)
+	if (!PlayerPawn || !GameInstance || !PlayerPawn->IsPlayerControlled()) return;
+
+	// Set the new spawn location and offset its Z axis so the player spawns above the terrain
+	FVector NewSpawnLocation = GetActorLocation() + FVector(0.f, 0.f, ZOffset);
+	if (GameInstance->ActivateCheckpoint(GetCheckpointId(), CheckpointOrder, NewSpawnLocation, Cast<APlayerCharacter>(PlayerPawn)))
 	{
-		APlayerController* PlayerController = Cast<APlayerController>(PlayerPawn->GetController());
+		// Debug saved location to screen
+		GP3_SCREEN_MESSAGE(this, 5.f, FColor::Green, GameInstance->GetCurrentCheckpointLocation().ToString());
+		GameInstance->SetStreamingCheckpoint(this);
 
-		if (PlayerController)
+		if (UGP3ReplaySubsystem* Replay = GetWorld()->GetSubsystem<UGP3ReplaySubsystem>())
 		{
-			// Set the new spawn location and offset its Z axis so the player spawns above the terrain
-			FVector NewSpawnLocation = GetActorLocation() + FVector(0.f, 0.f, ZOffset);
-			Cast<UGP3GameInstance>(GetGameInstance())->SetCurrentCheckpointLocation(NewSpawnLocation);
+			Replay->RecordCheckpoint(PlayerPawn, GetCheckpointId(), CheckpointOrder);
+		}
+	}
+}
+
+void ACheckpoint::PinStreaming()
+{
+	GetWorldTimerManager().ClearTimer(UnpinRetryHandle);
+	bIsPinned = true;
+	StreamingSource->EnableStreamingSource();
+
+	for (const TSoftObjectPtr<UWorld>& Level : StreamingLevels)
+	{
+		if (Level.IsNull()) continue;
+		if (PinnedLevels.ContainsByPredicate([&Level](const FPinnedLevel& Pinned) { return Pinned.Level == Level; })) continue;
+
+		// a level something else already loaded is left for that to unload
+		const ULevelStreaming* Streaming = UGameplayStatics::GetStreamingLevel(this, FName(*Level.GetLongPackageName()));
+		if (Streaming && Streaming->ShouldBeLoaded()) continue;
 
-			// Debug saved location to screen
-			FVector Location = Cast<UGP3GameInstance>(GetGameInstance())->GetCurrentCheckpointLocation();
-			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Green, Location.ToString());
+		PinnedLevels.Add({ Level });
+
+		// each pending request needs its own id or the latent manager drops it
+		FLatentActionInfo LatentInfo;
+		LatentInfo.CallbackTarget = this;
+		LatentInfo.UUID = NextStreamingRequestId++;
+		UGameplayStatics::LoadStreamLevelBySoftObjectPtr(this, Level, true, false, LatentInfo);
+	}
+}
+
+void ACheckpoint::UnpinStreaming(ACheckpoint* NextCheckpoint)
+{
+	bIsPinned = false;
+
+	// cells around the player stay loaded through the player's own streaming source
+	StreamingSource->DisableStreamingSource();
+
+	// the next checkpoint saw these as already loaded, so it has to own their unload from now on
+	if (NextCheckpoint)
+	{
+		for (int32 Index = PinnedLevels.Num() - 1; Index >= 0; --Index)
+		{
+			if (!NextCheckpoint->StreamingLevels.Contains(PinnedLevels[Index].Level)) continue;
+
+			NextCheckpoint->PinnedLevels.Add(PinnedLevels[Index]);
+			PinnedLevels.RemoveAtSwap(Index);
 		}
 	}
+
+	TryUnpinStreaming();
+}
+
+void ACheckpoint::TryUnpinStreaming()
+{
+	if (bIsPinned) return;
+
+	const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+	const float UnpinDistanceSquared = FMath::Square(UnpinDistance);
+
+	for (int32 Index = PinnedLevels.Num() - 1; Index >= 0; --Index)
+	{
+		FPinnedLevel& Pinned = PinnedLevels[Index];
+		const ULevelStreaming* Streaming = UGameplayStatics::GetStreamingLevel(this, FName(*Pinned.Level.GetLongPackageName()));
+		const ULevel* LoadedLevel = Streaming ? Streaming->GetLoadedLevel() : nullptr;
+
+		// bounds are only known once the level finished loading
+		if (!LoadedLevel && Streaming && Streaming->ShouldBeLoaded()) continue;
+		if (LoadedLevel && !Pinned.Bounds.IsValid)
+		{
+			Pinned.Bounds = ALevelBounds::CalculateLevelBounds(LoadedLevel);
+		}
+
+		if (PlayerPawn && Pinned.Bounds.IsValid && Pinned.Bounds.ComputeSquaredDistanceToPoint(PlayerPawn->GetActorLocation()) < UnpinDistanceSquared) continue;
+
+		FLatentActionInfo LatentInfo;
+		LatentInfo.CallbackTarget = this;
+		LatentInfo.UUID = NextStreamingRequestId++;
+		UGameplayStatics::UnloadStreamLevelBySoftObjectPtr(this, Pinned.Level, LatentInfo, false);
+		PinnedLevels.RemoveAtSwap(Index);
+	}
+
+	if (PinnedLevels.Num() > 0)
+	{
+		GetWorldTimerManager().SetTimer(UnpinRetryHandle, this, &ACheckpoint::TryUnpinStreaming, 1.f, false);
+	}
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "GameFramework/Actor.h"
 #include "Checkpoint.generated.h"
 
+class UGP3GameInstance;
+class UWorldPartitionStreamingSourceComponent;
+
 UCLASS()
 class GP3_TEAM4_API ACheckpoint : public AActor
 {
@@ -19,16 +22,66 @@ public:
 	
 	ACheckpoint();
 
+	// Identifies the checkpoint in save games, falls back to the actor name when unset
+	UFUNCTION(BlueprintCallable)
+	FName GetCheckpointId() const { return CheckpointId.IsNone() ? GetFName() : CheckpointId; }
+
+	// Starts loading everything a respawn here needs in the background and keeps it loaded
+	void PinStreaming();
+
+	// Lets the levels this pin loaded unload again once the player is UnpinDistance away from each of them,
+	// levels NextCheckpoint also streams are handed over to it instead
+	void UnpinStreaming(ACheckpoint* NextCheckpoint);
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	float ZOffset = 50.f;
 
+	UPROPERTY(EditAnywhere)
+	FName CheckpointId;
+
+	// Checkpoints can only be activated in increasing order, equal orders can be taken in any order
+	UPROPERTY(EditAnywhere)
+	int32 CheckpointOrder = 0;
+
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
 	UBoxComponent* TriggerBoxComponent;
+
+	// Streaming levels around the respawn point, loaded while this is the active checkpoint
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	TArray<TSoftObjectPtr<UWorld>> StreamingLevels;
+
+	// World partition cells around the respawn point, only a streaming source while this is the active checkpoint
+	UPROPERTY(VisibleAnywhere, Category = Streaming)
+	UWorldPartitionStreamingSourceComponent* StreamingSource;
+
+	// A pinned level stays loaded while the player is closer than this to its bounds, even after another checkpoint took over
+	UPROPERTY(EditAnywhere, Category = Streaming)
+	float UnpinDistance = 5000.f;
+
+private:
+	struct FPinnedLevel
+	{
+		TSoftObjectPtr<UWorld> Level;
+
+		// Bounds of the loaded level's actors, taken the first time the unpin checks it
+		FBox Bounds = FBox(ForceInit);
+	};
+
+	// Unloads released levels the player is far enough from, checks the rest again later
+	void TryUnpinStreaming();
+
+	UGP3GameInstance* GameInstance;
+
+	int32 NextStreamingRequestId = 0;
+
+	// Levels this checkpoint's pin loaded itself, levels that were already loaded are never unloaded by it
+	TArray<FPinnedLevel> PinnedLevels;
+
+	bool bIsPinned = false;
+
+	FTimerHandle UnpinRetryHandle;
 };
@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Items/CollectablePoolSubsystem.h"
+#include "Characters/PlayerCharacter.h"
+#include "GP3Benchmark.h"
+#include "GP3Stats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Collectable Pickups"), STAT_GP3_CollectablePickups, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Collectables Picked Up Per Frame"), STAT_GP3_CollectablesPickedUp, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Collectables Spawned Per Frame"), STAT_GP3_CollectablesSpawned, STATGROUP_GP3Gameplay);
+
+AActor* UCollectablePoolSubsystem::AcquireCollectable(TSubclassOf<AActor> CollectableClass, const FTransform& Transform, ECollectableType Type, int32 Value)
+{
+	if (!CollectableClass || !HasAuthority()) return nullptr;
+
+	AActor* Collectable = nullptr;
+	if (FCollectablePool* Pool = FreeCollectables.Find(CollectableClass))
+	{
+		while (!Collectable && Pool->Actors.Num() > 0)
+		{
+			Collectable = Pool->Actors.Pop(false);
+			if (!IsValid(Collectable))
+			{
+				Collectable = nullptr;
+			}
+		}
+	}
+
+	if (Collectable)
+	{
+		Collectable->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		SetCollectableActive(Collectable, true);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Collectable = GetWorld()->SpawnActor<AActor>(CollectableClass, Transform, SpawnParams);
+		if (!Collectable) return nullptr;
+
+		INC_DWORD_STAT(STAT_GP3_CollectablesSpawned);
+	}
+
+	RegisterCollectable(Collectable, Type, Value);
+	return Collectable;
+}
+
+void UCollectablePoolSubsystem::RegisterCollectable(AActor* Collectable, ECollectableType Type, int32 Value)
+{
+	const int32 Slot = FElementPocket::ToIndex(Type);
+	if (!Collectable || Slot == INDEX_NONE || !HasAuthority()) return;
+
+	// registering again moves the entry to the actor's current cell
+	if (const int32* ExistingIndex = ActiveIndexByActor.Find(Collectable))
+	{
+		RemoveActiveAt(*ExistingIndex);
+	}
+
+	FActiveCollectable Entry;
+	Entry.Actor = Collectable;
+	Entry.ActorKey = Collectable;
+	Entry.Location = Collectable->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+	Entry.Slot = Slot;
+	Entry.Value = Value;
+
+	const int32 Index = ActiveCollectables.Add(Entry);
+	Cells.FindOrAdd(Entry.Cell).Add(Index);
+	ActiveIndexByActor.Add(Collectable, Index);
+}
+
+void UCollectablePoolSubsystem::ReleaseCollectable(AActor* Collectable)
+{
+	if (const int32* Index = ActiveIndexByActor.Find(Collectable))
+	{
+		ReleaseActiveAt(*Index);
+	}
+}
+
+void UCollectablePoolSubsystem::RegisterCollector(APlayerCharacter* Character)
+{
+	if (Character)
+	{
+		Collectors.AddUnique(Character);
+	}
+}
+
+void UCollectablePoolSubsystem::UnregisterCollector(APlayerCharacter* Character)
+{
+	Collectors.RemoveSwap(Character);
+}
+
+void UCollectablePoolSubsystem::Tick(float DeltaTime)
+{
+	// clients never register collectables, their pockets and the orbs' visibility come from the server
+	if (!HasAuthority()) return;
+
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_CollectablePickups);
+	GP3_BENCHMARK_SCOPE("CollectablePickups");
+
+	for (APlayerCharacter* Character : Collectors)
+	{
+		if (!IsValid(Character) || ActiveCollectables.Num() == 0) continue;
+
+		const FVector CollectorLocation = Character->GetActorLocation();
+		const float Radius = Character->GetPickupRadius();
+		const float RadiusSquared = FMath::Square(Radius);
+		const FIntVector MinCell = GetCell(CollectorLocation - FVector(Radius));
+		const FIntVector MaxCell = GetCell(CollectorLocation + FVector(Radius));
+
+		// room left per element, shrinks with every orb taken so the pocket never overfills
+		const FElementPocket& Pocket = Character->GetPocket();
+		int32 Space[FElementPocket::NumElements];
+		for (int32 Slot = 0; Slot < FElementPocket::NumElements; ++Slot)
+		{
+			Space[Slot] = Pocket.MaxAmount[Slot] - Pocket.Count[Slot];
+		}
+
+		int32 Sums[FElementPocket::NumElements] = {};
+		PickedUp.Reset();
+
+		for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+				{
+					const TArray<int32>* CellEntries = Cells.Find(FIntVector(X, Y, Z));
+					if (!CellEntries) continue;
+
+					for (const int32 Index : *CellEntries)
+					{
+						const FActiveCollectable& Entry = ActiveCollectables[Index];
+						if (!Entry.Actor.IsValid())
+						{
+							// destroyed while waiting, ReleaseActiveAt only unlinks it
+							PickedUp.Add(Index);
+							continue;
+						}
+
+						// leave orbs on the ground that don't fit in what's left of the pocket
+						if (Entry.Value > Space[Entry.Slot]) continue;
+						if (FVector::DistSquared(CollectorLocation, Entry.Location) > RadiusSquared) continue;
+
+						Space[Entry.Slot] -= Entry.Value;
+						Sums[Entry.Slot] += Entry.Value;
+						PickedUp.Add(Index);
+						INC_DWORD_STAT(STAT_GP3_CollectablesPickedUp);
+					}
+				}
+			}
+		}
+
+		if (PickedUp.Num() == 0) continue;
+
+		for (const int32 Index : PickedUp)
+		{
+			ReleaseActiveAt(Index);
+		}
+		Character->GotCollectables(Sums);
+	}
+}
+
+TStatId UCollectablePoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCollectablePoolSubsystem, STATGROUP_Tickables);
+}
+
+void UCollectablePoolSubsystem::Deinitialize()
+{
+	FreeCollectables.Empty();
+	ActiveCollectables.Empty();
+	Cells.Empty();
+	ActiveIndexByActor.Empty();
+	Collectors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCollectablePoolSubsystem::ReleaseActiveAt(int32 Index)
+{
+	AActor* Collectable = RemoveActiveAt(Index);
+	if (!IsValid(Collectable)) return;
+
+	SetCollectableActive(Collectable, false);
+	FreeCollectables.FindOrAdd(Collectable->GetClass()).Actors.Add(Collectable);
+}
+
+AActor* UCollectablePoolSubsystem::RemoveActiveAt(int32 Index)
+{
+	const FActiveCollectable& Entry = ActiveCollectables[Index];
+	if (TArray<int32>* CellEntries = Cells.Find(Entry.Cell))
+	{
+		CellEntries->RemoveSingleSwap(Index);
+		if (CellEntries->Num() == 0)
+		{
+			Cells.Remove(Entry.Cell);
+		}
+	}
+	ActiveIndexByActor.Remove(Entry.ActorKey);
+
+	AActor* Collectable = Entry.Actor.Get();
+	ActiveCollectables.RemoveAt(Index);
+	return Collectable;
+}
+
+bool UCollectablePoolSubsystem::HasAuthority() const
+{
+	return GetWorld()->GetNetMode() != NM_Client;
+}
+
+FIntVector UCollectablePoolSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UCollectablePoolSubsystem::SetCollectableActive(AActor* Collectable, bool bIsActive)
+{
+	Collectable->SetActorHiddenInGame(!bIsActive);
+	Collectable->SetActorEnableCollision(bIsActive);
+	Collectable->SetActorTickEnabled(bIsActive);
+}
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Characters/ElementPocket.h"
+#include "CollectablePoolSubsystem.generated.h"
+
+class APlayerCharacter;
+
+USTRUCT()
+struct FCollectablePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AActor*> Actors;
+};
+
+/**
+ * Recycles collectable actors instead of spawning and destroying one per drop, and
+ * resolves pickups for every registered character once per frame. Each character
+ * gets the sum of everything inside its pickup radius in a single pocket update.
+ * Waiting collectables sit in a uniform grid and are treated as static once
+ * registered: one that moves has to register again. Only servers and standalone
+ * games pool and collect, clients see the results through replication.
+ */
+UCLASS()
+class GP3_TEAM4_API UCollectablePoolSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Takes a free actor of the class from the pool, spawning one only if the pool is empty
+	UFUNCTION(BlueprintCallable)
+	AActor* AcquireCollectable(TSubclassOf<AActor> CollectableClass, const FTransform& Transform, ECollectableType Type, int32 Value);
+
+	// Tracks an already spawned collectable, e.g. one placed in the level
+	UFUNCTION(BlueprintCallable)
+	void RegisterCollectable(AActor* Collectable, ECollectableType Type, int32 Value);
+
+	// Hides the actor and returns it to its class's pool
+	UFUNCTION(BlueprintCallable)
+	void ReleaseCollectable(AActor* Collectable);
+
+	void RegisterCollector(APlayerCharacter* Character);
+
+	void UnregisterCollector(APlayerCharacter* Character);
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	struct FActiveCollectable
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TObjectKey<AActor> ActorKey;
+		FVector Location;
+		FIntVector Cell;
+		int32 Slot;
+		int32 Value;
+	};
+
+	void ReleaseActiveAt(int32 Index);
+
+	// Unlinks the entry from the grid, returns its actor if it is still alive
+	AActor* RemoveActiveAt(int32 Index);
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Pickups, pooling and hiding only run where the pockets are authoritative
+	bool HasAuthority() const;
+
+	static void SetCollectableActive(AActor* Collectable, bool bIsActive);
+
+	UPROPERTY()
+	TMap<UClass*, FCollectablePool> FreeCollectables;
+
+	// Should be at least the largest pickup radius so a query touches a handful of cells
+	float CellSize = 300.f;
+
+	TSparseArray<FActiveCollectable> ActiveCollectables;
+
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	TMap<TObjectKey<AActor>, int32> ActiveIndexByActor;
+
+	// Scratch list of the entries picked up by one collector, released after its cells are walked
+	TArray<int32> PickedUp;
+
+	UPROPERTY()
+	TArray<APlayerCharacter*> Collectors;
+};
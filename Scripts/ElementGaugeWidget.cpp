@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "UI/ElementGaugeWidget.h"
+#include "Characters/PlayerCharacter.h"
+
+#include "Components/ProgressBar.h"
+#include "Components/TextBlock.h"
+
+void UElementGaugeWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	// widgets created before the pawn is possessed, or kept across a respawn, pick up the new pawn here
+	if (APlayerController* PlayerController = GetOwningPlayer())
+	{
+		PlayerController->OnPossessedPawnChanged.AddUniqueDynamic(this, &UElementGaugeWidget::OnPossessedPawnChanged);
+	}
+
+	if (!Character.IsValid())
+	{
+		SetCharacter(Cast<APlayerCharacter>(GetOwningPlayerPawn()));
+	}
+}
+
+void UElementGaugeWidget::NativeDestruct()
+{
+	if (APlayerController* PlayerController = GetOwningPlayer())
+	{
+		PlayerController->OnPossessedPawnChanged.RemoveDynamic(this, &UElementGaugeWidget::OnPossessedPawnChanged);
+	}
+	SetCharacter(nullptr);
+
+	Super::NativeDestruct();
+}
+
+void UElementGaugeWidget::SetCharacter(APlayerCharacter* NewCharacter)
+{
+	if (APlayerCharacter* OldCharacter = Character.Get())
+	{
+		OldCharacter->OnPocketChanged.RemoveDynamic(this, &UElementGaugeWidget::OnPocketChanged);
+		OldCharacter->OnTankChanged.RemoveDynamic(this, &UElementGaugeWidget::OnTankChanged);
+		OldCharacter->OnAbilityLevelChanged.RemoveDynamic(this, &UElementGaugeWidget::OnAbilityLevelChanged);
+	}
+
+	Character = NewCharacter;
+	if (!NewCharacter) return;
+
+	NewCharacter->OnPocketChanged.AddDynamic(this, &UElementGaugeWidget::OnPocketChanged);
+	NewCharacter->OnTankChanged.AddDynamic(this, &UElementGaugeWidget::OnTankChanged);
+	NewCharacter->OnAbilityLevelChanged.AddDynamic(this, &UElementGaugeWidget::OnAbilityLevelChanged);
+
+	// events only carry changes, so start from the character's current state
+	OnPocketChanged(Element, NewCharacter->GetPocket().GetPercentage(Element));
+	OnTankChanged(Element, NewCharacter->GetTankPercentage(Element));
+	OnAbilityLevelChanged(Element, NewCharacter->GetAbilityLevel(Element));
+}
+
+void UElementGaugeWidget::OnPocketChanged(ECollectableType Type, float Percentage)
+{
+	if (Type == Element && Gauge)
+	{
+		Gauge->SetPercent(Percentage);
+	}
+}
+
+void UElementGaugeWidget::OnTankChanged(ECollectableType Type, float Percentage)
+{
+	if (Type == Element && TankGauge)
+	{
+		TankGauge->SetPercent(Percentage);
+	}
+}
+
+void UElementGaugeWidget::OnAbilityLevelChanged(ECollectableType Type, EAbilityLevel NewLevel)
+{
+	if (Type == Element && LevelText)
+	{
+		LevelText->SetText(UEnum::GetDisplayValueAsText(NewLevel));
+	}
+}
+
+void UElementGaugeWidget::OnPossessedPawnChanged(APawn* OldPawn, APawn* NewPawn)
+{
+	SetCharacter(Cast<APlayerCharacter>(NewPawn));
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "CharacterTypes.h"
+#include "Items/ItemTypes.h"
+#include "ElementGaugeWidget.generated.h"
+
+class UProgressBar;
+class UTextBlock;
+class APlayerCharacter;
+
+/**
+ * Pocket, tank and ability level readout for one element. It never ticks and has no
+ * property bindings: each part only changes when the character broadcasts OnPocketChanged,
+ * OnTankChanged or OnAbilityLevelChanged. Place it inside an Invalidation Box so the rest
+ * of the HUD stays cached between changes. It follows whatever pawn the owning player possesses.
+ */
+UCLASS(meta = (DisableNativeTick))
+class GP3_TEAM4_API UElementGaugeWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+
+	// Switches the gauge to another character, nullptr just unbinds it
+	UFUNCTION(BlueprintCallable)
+	void SetCharacter(APlayerCharacter* NewCharacter);
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Gauge)
+	ECollectableType Element = ECollectableType::ECT_Earth;
+
+protected:
+
+	virtual void NativeConstruct() override;
+
+	virtual void NativeDestruct() override;
+
+	// Pocket fill
+	UPROPERTY(meta = (BindWidget))
+	UProgressBar* Gauge;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UProgressBar* TankGauge;
+
+	UPROPERTY(meta = (BindWidgetOptional))
+	UTextBlock* LevelText;
+
+private:
+
+	UFUNCTION()
+	void OnPocketChanged(ECollectableType Type, float Percentage);
+
+	UFUNCTION()
+	void OnTankChanged(ECollectableType Type, float Percentage);
+
+	UFUNCTION()
+	void OnAbilityLevelChanged(ECollectableType Type, EAbilityLevel NewLevel);
+
+	UFUNCTION()
+	void OnPossessedPawnChanged(APawn* OldPawn, APawn* NewPawn);
+
+	TWeakObjectPtr<APlayerCharacter> Character;
+};
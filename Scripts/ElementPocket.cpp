@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/ElementPocket.h"
+
+int32 FElementPocket::ToIndex(ECollectableType Type)
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		if (Elements[Index] == Type)
+		{
+			return Index;
+		}
+	}
+	return INDEX_NONE;
+}
+
+FElementPocket::FElementPocket()
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		MaxAmount[Index] = 100;
+		Count[Index] = 0;
+	}
+}
+
+int32 FElementPocket::Get(ECollectableType Type) const
+{
+	const int32 Index = ToIndex(Type);
+	return Index != INDEX_NONE ? Count[Index] : 0;
+}
+
+float FElementPocket::GetPercentage(ECollectableType Type) const
+{
+	const int32 Index = ToIndex(Type);
+	if (Index == INDEX_NONE || MaxAmount[Index] <= 0) return 0.f;
+	return (float)Count[Index] / (float)MaxAmount[Index];
+}
+
+bool FElementPocket::Add(ECollectableType Type, int32 Value)
+{
+	const int32 Index = ToIndex(Type);
+	if (Index == INDEX_NONE || Count[Index] >= MaxAmount[Index]) return false;
+
+	Count[Index] = FMath::Min(Count[Index] + Value, MaxAmount[Index]);
+	return true;
+}
+
+void FElementPocket::Remove(ECollectableType Type, int32 Value)
+{
+	const int32 Index = ToIndex(Type);
+	if (Index == INDEX_NONE) return;
+
+	Count[Index] = FMath::Max(Count[Index] - Value, 0);
+}
+
+void FElementPocket::AddAll(const int32 (&Values)[NumElements])
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		Count[Index] = FMath::Clamp(Count[Index] + Values[Index], 0, MaxAmount[Index]);
+	}
+}
+
+void FElementPocket::DrainAll(int32 Value)
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		Count[Index] = FMath::Max(Count[Index] - Value, 0);
+	}
+}
+
+void FElementPocket::ClampAll()
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		Count[Index] = FMath::Clamp(Count[Index], 0, MaxAmount[Index]);
+	}
+}
+
+bool FElementPocket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		uint32 Value = static_cast<uint32>(FMath::Max(Count[Index], 0));
+		Ar.SerializeIntPacked(Value);
+		if (Ar.IsLoading())
+		{
+			// caps come from the class defaults on both ends
+			Count[Index] = FMath::Min(static_cast<int32>(Value), MaxAmount[Index]);
+		}
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Items/ItemTypes.h"
+#include "ElementPocket.generated.h"
+
+/**
+ * Essence carried by a character, one contiguous slot per element.
+ * Adding an element only means adding it to Elements and bumping NumElements.
+ */
+USTRUCT(BlueprintType)
+struct GP3_TEAM4_API FElementPocket
+{
+	GENERATED_BODY()
+
+	static constexpr int32 NumElements = 3;
+
+	static constexpr ECollectableType Elements[NumElements] =
+	{
+		ECollectableType::ECT_Earth,
+		ECollectableType::ECT_Wind,
+		ECollectableType::ECT_Fire
+	};
+
+	// Slot of the element in the pocket arrays, INDEX_NONE for types that aren't pocketed
+	static int32 ToIndex(ECollectableType Type);
+
+	UPROPERTY(EditDefaultsOnly, Category = Collect)
+	int32 MaxAmount[NumElements];
+
+	UPROPERTY(VisibleAnywhere, Category = Collect)
+	int32 Count[NumElements];
+
+	FElementPocket();
+
+	int32 Get(ECollectableType Type) const;
+
+	float GetPercentage(ECollectableType Type) const;
+
+	// Adds up to the element's max, returns false if the element isn't pocketed or was already full
+	bool Add(ECollectableType Type, int32 Value);
+
+	void Remove(ECollectableType Type, int32 Value);
+
+	// Adds each value to its slot and clamps every element in one pass
+	void AddAll(const int32 (&Values)[NumElements]);
+
+	void DrainAll(int32 Value);
+
+	void ClampAll();
+
+	// Only the counts go over the wire, packed so a near-empty pocket costs a few bits per element
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FElementPocket> : public TStructOpsTypeTraitsBase2<FElementPocket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
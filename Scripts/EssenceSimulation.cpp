@@ -0,0 +1,241 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Essence/EssenceSimulation.h"
+
+#include "Async/ParallelFor.h"
+
+// Entities per ParallelFor task, small worlds run on the calling thread
+static constexpr int32 EssenceBatchSize = 256;
+
+FEssenceSimulation::FEssenceSimulation(const FRules& InRules)
+	: Rules(InRules)
+{
+}
+
+int32 FEssenceSimulation::AddEntity(const int32 (&InPocketMax)[NumElements])
+{
+	int32 Entity;
+	if (FreeEntities.Num() > 0)
+	{
+		Entity = FreeEntities.Pop(false);
+	}
+	else
+	{
+		Entity = IsActive.Num();
+		for (int32 Element = 0; Element < NumElements; ++Element)
+		{
+			PocketCount[Element].AddUninitialized();
+			PocketMax[Element].AddUninitialized();
+			TankCount[Element].AddUninitialized();
+			Level[Element].AddUninitialized();
+		}
+		Overloaded.AddUninitialized();
+		DrainElapsed.AddUninitialized();
+		TransferElement.AddUninitialized();
+		TransferPending.AddUninitialized();
+		DirtyFlags.AddUninitialized();
+		IsActive.AddUninitialized();
+	}
+
+	for (int32 Element = 0; Element < NumElements; ++Element)
+	{
+		PocketCount[Element][Entity] = 0;
+		PocketMax[Element][Entity] = InPocketMax[Element];
+		TankCount[Element][Entity] = 0;
+		Level[Element][Entity] = 0;
+	}
+	Overloaded[Entity] = 0;
+	DrainElapsed[Entity] = 0.f;
+	TransferElement[Entity] = INDEX_NONE;
+	TransferPending[Entity] = 0.f;
+	DirtyFlags[Entity] = 0;
+	IsActive[Entity] = 1;
+	return Entity;
+}
+
+void FEssenceSimulation::RemoveEntity(int32 Entity)
+{
+	if (!IsValidEntity(Entity)) return;
+
+	IsActive[Entity] = 0;
+	FreeEntities.Add(Entity);
+}
+
+bool FEssenceSimulation::Collect(int32 Entity, int32 Element, int32 Value)
+{
+	if (!IsValidElement(Element)) return false;
+
+	int32& Count = PocketCount[Element][Entity];
+	const int32 Max = PocketMax[Element][Entity];
+	if (Count >= Max) return false;
+
+	Count = FMath::Min(Count + Value, Max);
+	DirtyFlags[Entity] |= Dirty_Pocket;
+	return true;
+}
+
+void FEssenceSimulation::SetPocket(int32 Entity, int32 Element, int32 Value)
+{
+	if (!IsValidElement(Element)) return;
+
+	PocketCount[Element][Entity] = FMath::Clamp(Value, 0, PocketMax[Element][Entity]);
+	DirtyFlags[Entity] |= Dirty_Pocket;
+}
+
+int32 FEssenceSimulation::RemoveFromPocket(int32 Entity, int32 Element, int32 Value)
+{
+	if (!IsValidElement(Element)) return 0;
+
+	int32& Count = PocketCount[Element][Entity];
+	const int32 Amount = FMath::Clamp(Value, 0, Count);
+	if (Amount > 0)
+	{
+		Count -= Amount;
+		DirtyFlags[Entity] |= Dirty_Pocket;
+	}
+	return Amount;
+}
+
+void FEssenceSimulation::SetTank(int32 Entity, int32 Element, int32 Value)
+{
+	if (!IsValidElement(Element)) return;
+
+	TankCount[Element][Entity] = FMath::Clamp(Value, 0, Rules.TankCapacity[Element]);
+	DirtyFlags[Entity] |= Dirty_Tank;
+	UpdateDerived(Entity);
+}
+
+void FEssenceSimulation::StartTransfer(int32 Entity, int32 Element)
+{
+	if (!IsValidElement(Element) || PocketCount[Element][Entity] <= 0) return;
+
+	TransferElement[Entity] = static_cast<int8>(Element);
+	TransferPending[Entity] = 0.f;
+}
+
+void FEssenceSimulation::StopTransfer(int32 Entity)
+{
+	TransferElement[Entity] = INDEX_NONE;
+	TransferPending[Entity] = 0.f;
+}
+
+void FEssenceSimulation::Drain(int32 Entity, int32 Value)
+{
+	DrainTank(Entity, Value);
+	UpdateDerived(Entity);
+}
+
+int32 FEssenceSimulation::FillQuestTank(int32 Entity, int32 Element, int32 Value, int32 QuestTankSpace)
+{
+	return RemoveFromPocket(Entity, Element, FMath::Min(Value, QuestTankSpace));
+}
+
+void FEssenceSimulation::Step(float DeltaTime)
+{
+	const int32 NumEntities = Num();
+	const int32 NumBatches = FMath::DivideAndRoundUp(NumEntities, EssenceBatchSize);
+
+	// every entity only touches its own slots, so batches need no synchronization
+	ParallelFor(NumBatches, [this, NumEntities, DeltaTime](int32 Batch)
+	{
+		const int32 End = FMath::Min((Batch + 1) * EssenceBatchSize, NumEntities);
+		for (int32 Entity = Batch * EssenceBatchSize; Entity < End; ++Entity)
+		{
+			StepEntity(Entity, DeltaTime);
+		}
+	}, NumBatches <= 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+uint8 FEssenceSimulation::ConsumeDirtyFlags(int32 Entity)
+{
+	const uint8 Flags = DirtyFlags[Entity];
+	DirtyFlags[Entity] = 0;
+	return Flags;
+}
+
+void FEssenceSimulation::StepEntity(int32 Entity, float DeltaTime)
+{
+	if (!IsActive[Entity]) return;
+
+	const int32 Element = TransferElement[Entity];
+	if (Element != INDEX_NONE)
+	{
+		int32& Pocket = PocketCount[Element][Entity];
+		int32& Tank = TankCount[Element][Entity];
+
+		TransferPending[Entity] += Rules.TransferRate * DeltaTime;
+		const int32 Capacity = Rules.TankCapacity[Element];
+		const int32 Amount = FMath::Min3(FMath::FloorToInt(TransferPending[Entity]), Pocket, Capacity - Tank);
+		if (Amount > 0)
+		{
+			Pocket -= Amount;
+			Tank += Amount;
+			TransferPending[Entity] -= Amount;
+			DirtyFlags[Entity] |= Dirty_Pocket | Dirty_Tank;
+		}
+
+		if (Pocket <= 0 || Tank >= Capacity)
+		{
+			StopTransfer(Entity);
+		}
+	}
+
+	if (Overloaded[Entity])
+	{
+		DrainElapsed[Entity] += DeltaTime;
+		while (DrainElapsed[Entity] >= Rules.DrainInterval && Overloaded[Entity])
+		{
+			DrainElapsed[Entity] -= Rules.DrainInterval;
+			DrainTank(Entity, Rules.DrainAmount);
+			UpdateDerived(Entity);
+		}
+	}
+
+	if (DirtyFlags[Entity] & Dirty_Tank)
+	{
+		UpdateDerived(Entity);
+	}
+}
+
+void FEssenceSimulation::DrainTank(int32 Entity, int32 Value)
+{
+	for (int32 Element = 0; Element < NumElements; ++Element)
+	{
+		int32& Tank = TankCount[Element][Entity];
+		if (Tank > 0)
+		{
+			Tank = FMath::Max(Tank - Value, 0);
+			DirtyFlags[Entity] |= Dirty_Tank;
+		}
+	}
+}
+
+void FEssenceSimulation::UpdateDerived(int32 Entity)
+{
+	int32 Total = 0;
+	for (int32 Element = 0; Element < NumElements; ++Element)
+	{
+		const int32 Tank = TankCount[Element][Entity];
+		Total += Tank;
+
+		uint8 NewLevel = 0;
+		while (NewLevel < NumLevelThresholds && Tank >= Rules.LevelThresholds[NewLevel])
+		{
+			++NewLevel;
+		}
+		if (NewLevel != Level[Element][Entity])
+		{
+			Level[Element][Entity] = NewLevel;
+			DirtyFlags[Entity] |= Dirty_Level;
+		}
+	}
+
+	const uint8 bNowOverloaded = Total > Rules.OverloadThreshold ? 1 : 0;
+	if (bNowOverloaded != Overloaded[Entity])
+	{
+		Overloaded[Entity] = bNowOverloaded;
+		DrainElapsed[Entity] = 0.f;
+		DirtyFlags[Entity] |= Dirty_Overload;
+	}
+}
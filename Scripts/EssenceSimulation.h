@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Essence rules for pockets and tanks, free of any UObject so it can be stepped and
+ * profiled on its own. Entity state is kept as structure-of-arrays, Step advances
+ * held transfers, overload and drains for every entity in parallel batches.
+ * Elements are pocket slot indices, levels count the thresholds a tank has reached and
+ * are reported through FRules::LevelValues.
+ */
+class GP3_TEAM4_API FEssenceSimulation
+{
+public:
+
+	static constexpr int32 NumElements = 3;
+	static constexpr int32 NumLevelThresholds = 3;
+
+	// The defaults only serve standalone runs such as gp3.EssenceBenchmark,
+	// a world's simulation takes its rules from the player's tank component
+	struct FRules
+	{
+		int32 TankCapacity[NumElements] = { 100, 100, 100 };
+		// Total tank essence above which the tank overloads and starts draining
+		int32 OverloadThreshold = 200;
+		int32 DrainAmount = 1;
+		float DrainInterval = 2.f;
+		// Units per second moved from a pocket into the tank while a transfer is held
+		float TransferRate = 60.f;
+		// Ascending tank amounts that raise the level, unused ones are MAX_int32
+		int32 LevelThresholds[NumLevelThresholds] = { 25, 50, 75 };
+		// Level reported for each number of thresholds reached
+		uint8 LevelValues[NumLevelThresholds + 1] = { 0, 1, 2, 3 };
+	};
+
+	enum EDirtyFlags : uint8
+	{
+		Dirty_Pocket = 1 << 0,
+		Dirty_Tank = 1 << 1,
+		Dirty_Level = 1 << 2,
+		Dirty_Overload = 1 << 3
+	};
+
+	explicit FEssenceSimulation(const FRules& InRules = FRules());
+
+	const FRules& GetRules() const { return Rules; }
+
+	// Only meant for setup, entities that already exist keep their derived state until their tank changes
+	void SetRules(const FRules& InRules) { Rules = InRules; }
+
+	// Returns the entity index, slots of removed entities are reused
+	int32 AddEntity(const int32 (&PocketMax)[NumElements]);
+
+	void RemoveEntity(int32 Entity);
+
+	// Upper bound for entity indices, removed slots included
+	int32 Num() const { return IsActive.Num(); }
+
+	bool IsValidEntity(int32 Entity) const { return IsActive.IsValidIndex(Entity) && IsActive[Entity]; }
+
+	static bool IsValidElement(int32 Element) { return Element >= 0 && Element < NumElements; }
+
+	// Adds up to the pocket max, returns false if the pocket was already full
+	bool Collect(int32 Entity, int32 Element, int32 Value);
+
+	void SetPocket(int32 Entity, int32 Element, int32 Value);
+
+	// Takes up to Value out of the pocket, returns the amount removed
+	int32 RemoveFromPocket(int32 Entity, int32 Element, int32 Value);
+
+	// Sets the tank contents directly, e.g. restoring a checkpoint, levels and overload follow
+	void SetTank(int32 Entity, int32 Element, int32 Value);
+
+	// Held transfers move whole units each Step until the pocket is empty or the tank is full
+	void StartTransfer(int32 Entity, int32 Element);
+	void StopTransfer(int32 Entity);
+	bool IsTransferring(int32 Entity) const { return TransferElement[Entity] != INDEX_NONE; }
+
+	// Takes Value from every element in the tank
+	void Drain(int32 Entity, int32 Value);
+
+	// Moves up to Value from the pocket into a quest tank with QuestTankSpace left, returns the amount moved
+	int32 FillQuestTank(int32 Entity, int32 Element, int32 Value, int32 QuestTankSpace);
+
+	void Step(float DeltaTime);
+
+	int32 GetPocket(int32 Entity, int32 Element) const { return PocketCount[Element][Entity]; }
+	int32 GetTank(int32 Entity, int32 Element) const { return TankCount[Element][Entity]; }
+	// One of FRules::LevelValues
+	uint8 GetLevel(int32 Entity, int32 Element) const { return Rules.LevelValues[Level[Element][Entity]]; }
+	bool IsOverloaded(int32 Entity) const { return Overloaded[Entity] != 0; }
+
+	// Returns what changed since the last call and clears it
+	uint8 ConsumeDirtyFlags(int32 Entity);
+
+private:
+
+	void StepEntity(int32 Entity, float DeltaTime);
+
+	void DrainTank(int32 Entity, int32 Value);
+
+	// Recomputes overload and levels from the tank
+	void UpdateDerived(int32 Entity);
+
+	FRules Rules;
+
+	TArray<int32> PocketCount[NumElements];
+	TArray<int32> PocketMax[NumElements];
+	TArray<int32> TankCount[NumElements];
+	TArray<uint8> Level[NumElements];
+
+	TArray<uint8> Overloaded;
+	TArray<float> DrainElapsed;
+	TArray<int8> TransferElement;
+	TArray<float> TransferPending;
+	TArray<uint8> DirtyFlags;
+	TArray<uint8> IsActive;
+
+	TArray<int32> FreeEntities;
+};
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Essence/EssenceSimulationSubsystem.h"
+#include "Characters/PlayerCharacter.h"
+#include "Characters/Components/TankComponent.h"
+#include "GP3Benchmark.h"
+#include "GP3Log.h"
+#include "GP3Stats.h"
+
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Essence Step"), STAT_GP3_EssenceStep, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Essence Write Back"), STAT_GP3_EssenceWriteBack, STATGROUP_GP3Gameplay);
+
+static_assert(FEssenceSimulation::NumElements == FElementPocket::NumElements, "Essence simulation elements must match the pocket slots");
+
+#if !UE_BUILD_SHIPPING
+// Steps a standalone simulation without any actors, e.g. "gp3.EssenceBenchmark 10000 600"
+static FAutoConsoleCommand GP3EssenceBenchmarkCommand(
+	TEXT("gp3.EssenceBenchmark"),
+	TEXT("Steps a standalone essence simulation. Args: [Entities=10000] [Steps=600]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumEntities = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000, 1);
+		const int32 NumSteps = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 600, 1);
+
+		FEssenceSimulation Simulation;
+		const int32 PocketMax[FEssenceSimulation::NumElements] = { 100, 100, 100 };
+		for (int32 Index = 0; Index < NumEntities; ++Index)
+		{
+			Simulation.AddEntity(PocketMax);
+		}
+
+		uint64 TotalCycles = 0;
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			// keep every entity collecting and transferring so the step never idles
+			for (int32 Entity = 0; Entity < NumEntities; ++Entity)
+			{
+				const int32 Element = (Entity + Step / 30) % FEssenceSimulation::NumElements;
+				Simulation.Collect(Entity, Element, 5);
+				if ((Entity + Step) % 30 == 0)
+				{
+					Simulation.StartTransfer(Entity, Element);
+				}
+			}
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Simulation.Step(1.f / 60.f);
+			TotalCycles += FPlatformTime::Cycles64() - StartCycles;
+
+			for (int32 Entity = 0; Entity < NumEntities; ++Entity)
+			{
+				Simulation.ConsumeDirtyFlags(Entity);
+			}
+		}
+
+		GP3_LOG(Log, TEXT("Essence benchmark: %d entities, %d steps, avg step %.3f ms"), NumEntities, NumSteps, FPlatformTime::ToMilliseconds64(TotalCycles) / NumSteps);
+	}));
+#endif
+
+FEssenceSimulation::FRules UEssenceSimulationSubsystem::MakeRules(const UTankComponent& Tank, int32 DrainAmount, float DrainInterval, float TransferRate)
+{
+	FEssenceSimulation::FRules Rules;
+	for (int32 Element = 0; Element < FEssenceSimulation::NumElements; ++Element)
+	{
+		Rules.TankCapacity[Element] = Tank.GetTypeCapacity(FElementPocket::Elements[Element]);
+	}
+	Rules.OverloadThreshold = Tank.GetOverloadThreshold();
+	Rules.DrainAmount = DrainAmount;
+	Rules.DrainInterval = DrainInterval;
+	Rules.TransferRate = TransferRate;
+
+	const auto& Thresholds = Tank.GetLevelThresholds();
+	if (Thresholds.Num() > FEssenceSimulation::NumLevelThresholds)
+	{
+		GP3_LOG(Warning, TEXT("Essence simulation only tracks %d of the tank's %d level thresholds"), FEssenceSimulation::NumLevelThresholds, Thresholds.Num());
+	}
+
+	// levels are reported in EAbilityLevel order, one step per threshold reached
+	const UEnum* LevelEnum = StaticEnum<EAbilityLevel>();
+	for (int32 Index = 0; Index <= FEssenceSimulation::NumLevelThresholds; ++Index)
+	{
+		if (Index < FEssenceSimulation::NumLevelThresholds)
+		{
+			Rules.LevelThresholds[Index] = Thresholds.IsValidIndex(Index) ? Thresholds[Index] : MAX_int32;
+		}
+		const int32 LevelIndex = FMath::Min(Index, FMath::Min(Thresholds.Num(), LevelEnum->NumEnums() - 2));
+		Rules.LevelValues[Index] = static_cast<uint8>(LevelEnum->GetValueByIndex(LevelIndex));
+	}
+	return Rules;
+}
+
+int32 UEssenceSimulationSubsystem::RegisterCharacter(APlayerCharacter* Character, const FEssenceSimulation::FRules& Rules)
+{
+	if (!bHasRules)
+	{
+		Simulation.SetRules(Rules);
+		bHasRules = true;
+	}
+
+	const FElementPocket& Pocket = Character->GetPocket();
+	const int32 Entity = Simulation.AddEntity(Pocket.MaxAmount);
+	for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+	{
+		Simulation.SetPocket(Entity, Element, Pocket.Count[Element]);
+	}
+
+	if (Entity >= Owners.Num())
+	{
+		Owners.SetNumZeroed(Entity + 1);
+	}
+	Owners[Entity] = Character;
+	return Entity;
+}
+
+void UEssenceSimulationSubsystem::UnregisterCharacter(int32 Entity)
+{
+	if (!Owners.IsValidIndex(Entity)) return;
+
+	Owners[Entity] = nullptr;
+	Simulation.RemoveEntity(Entity);
+}
+
+void UEssenceSimulationSubsystem::Tick(float DeltaTime)
+{
+	{
+		GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_EssenceStep);
+		GP3_BENCHMARK_SCOPE("EssenceStep");
+
+		Simulation.Step(DeltaTime);
+	}
+
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_EssenceWriteBack);
+
+	// actors are only touched on the game thread, and only the ones whose state changed
+	for (int32 Entity = 0; Entity < Owners.Num(); ++Entity)
+	{
+		APlayerCharacter* Character = Owners[Entity];
+		if (!Character || !Simulation.IsValidEntity(Entity)) continue;
+
+		const uint8 DirtyFlags = Simulation.ConsumeDirtyFlags(Entity);
+		if (DirtyFlags != 0)
+		{
+			Character->ApplyEssenceState(Simulation, Entity, DirtyFlags);
+		}
+	}
+}
+
+TStatId UEssenceSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEssenceSimulationSubsystem, STATGROUP_Tickables);
+}
+
+void UEssenceSimulationSubsystem::Deinitialize()
+{
+	Owners.Empty();
+	bHasRules = false;
+
+	Super::Deinitialize();
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Essence/EssenceSimulation.h"
+#include "EssenceSimulationSubsystem.generated.h"
+
+class APlayerCharacter;
+class UTankComponent;
+
+/**
+ * Owns the world's essence simulation, steps every entity once per frame and
+ * writes pocket, level and overload changes back to the characters they belong to.
+ * Entities without an owner are simulated all the same, e.g. benchmark crowds.
+ */
+UCLASS()
+class GP3_TEAM4_API UEssenceSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Builds the simulation rules from the tank's capacities, thresholds and overload limit
+	static FEssenceSimulation::FRules MakeRules(const UTankComponent& Tank, int32 DrainAmount, float DrainInterval, float TransferRate);
+
+	// Adds an entity seeded with the character's pocket, returns its index.
+	// The first character's rules become the world's rules.
+	int32 RegisterCharacter(APlayerCharacter* Character, const FEssenceSimulation::FRules& Rules);
+
+	void UnregisterCharacter(int32 Entity);
+
+	FEssenceSimulation& GetSimulation() { return Simulation; }
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	FEssenceSimulation Simulation;
+
+	bool bHasRules = false;
+
+	// Indexed by entity, null for entities without a character
+	UPROPERTY()
+	TArray<APlayerCharacter*> Owners;
+};
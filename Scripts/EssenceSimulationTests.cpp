@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Essence/EssenceSimulation.h"
+#include "Essence/EssenceSimulationSubsystem.h"
+#include "Characters/Components/TankComponent.h"
+#include "Characters/ElementPocket.h"
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGP3EssenceSimulationMatchesTankTest, "GP3.Essence.SimulationMatchesTank",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+static void TestMatchesTank(FAutomationTestBase& Test, const FString& What, const FEssenceSimulation& Simulation, int32 Entity, const UTankComponent& Tank)
+{
+	for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+	{
+		const ECollectableType Type = FElementPocket::Elements[Element];
+		Test.TestEqual(FString::Printf(TEXT("%s: tank %d"), *What, Element), Simulation.GetTank(Entity, Element), static_cast<int32>(Tank.GetTypeAmount(Type)));
+		Test.TestEqual(FString::Printf(TEXT("%s: level %d"), *What, Element), static_cast<EAbilityLevel>(Simulation.GetLevel(Entity, Element)), Tank.CheckTypeLevel(Type));
+	}
+}
+
+// Feeds the same essence into a tank component and a simulated tank and checks they agree
+bool FGP3EssenceSimulationMatchesTankTest::RunTest(const FString& Parameters)
+{
+	UTankComponent* Tank = NewObject<UTankComponent>();
+
+	// one unit per second so a step moves a whole chunk, and no timed drain in between
+	FEssenceSimulation Simulation(UEssenceSimulationSubsystem::MakeRules(*Tank, 1, UE_BIG_NUMBER, 1.f));
+	const int32 PocketMax[FEssenceSimulation::NumElements] = { MAX_int32, MAX_int32, MAX_int32 };
+	const int32 Entity = Simulation.AddEntity(PocketMax);
+
+	for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+	{
+		const ECollectableType Type = FElementPocket::Elements[Element];
+		const int32 Capacity = Tank->GetTypeCapacity(Type);
+		const int32 Chunk = FMath::Max(Capacity / 8, 1);
+
+		// one chunk past the capacity so both sides have to clamp
+		for (int32 Added = 0; Added <= Capacity; Added += Chunk)
+		{
+			const int32 Accepted = FMath::Min(Chunk, FMath::Max(Capacity - Tank->GetTypeAmount(Type), 0));
+			if (Accepted > 0)
+			{
+				bool bIsTankFull = false;
+				Tank->AddEssence(Type, Accepted, bIsTankFull);
+			}
+
+			Simulation.Collect(Entity, Element, Chunk);
+			Simulation.StartTransfer(Entity, Element);
+			Simulation.Step(Chunk + 0.5f);
+			Simulation.StopTransfer(Entity);
+			Simulation.SetPocket(Entity, Element, 0);
+
+			TestMatchesTank(*this, FString::Printf(TEXT("Fill %d"), Added), Simulation, Entity, *Tank);
+		}
+	}
+
+	for (int32 Drain = 1; Drain <= 8; ++Drain)
+	{
+		bool bIsOverloaded = false;
+		Tank->DrainEssence(Drain * 3, bIsOverloaded);
+		Simulation.Drain(Entity, Drain * 3);
+
+		TestMatchesTank(*this, FString::Printf(TEXT("Drain %d"), Drain), Simulation, Entity, *Tank);
+		TestEqual(FString::Printf(TEXT("Drain %d: overloaded"), Drain), Simulation.IsOverloaded(Entity), bIsOverloaded);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3Benchmark.h"
+
+#if GP3_BENCHMARK_TIMING
+
+namespace GP3Benchmark
+{
+	bool bIsRecording = false;
+
+	// Keyed by the literal passed to GP3_BENCHMARK_SCOPE, only touched on the game thread
+	static TMap<const TCHAR*, FScopeStats> Stats;
+
+	void Record(const TCHAR* Name, uint64 Cycles)
+	{
+		FScopeStats& ScopeStats = Stats.FindOrAdd(Name);
+		ScopeStats.Calls++;
+		ScopeStats.TotalCycles += Cycles;
+		ScopeStats.MaxCycles = FMath::Max(ScopeStats.MaxCycles, Cycles);
+	}
+
+	void Reset()
+	{
+		Stats.Reset();
+	}
+
+	const TMap<const TCHAR*, FScopeStats>& GetStats()
+	{
+		return Stats;
+	}
+}
+
+#endif
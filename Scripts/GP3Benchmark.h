@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Scope timers feeding the gameplay benchmark, stripped from Shipping builds
+#define GP3_BENCHMARK_TIMING !UE_BUILD_SHIPPING
+
+#if GP3_BENCHMARK_TIMING
+
+namespace GP3Benchmark
+{
+	struct FScopeStats
+	{
+		uint64 Calls = 0;
+		uint64 TotalCycles = 0;
+		uint64 MaxCycles = 0;
+	};
+
+	// Only set while a benchmark run is sampling, scopes cost a branch otherwise
+	extern GP3_TEAM4_API bool bIsRecording;
+
+	GP3_TEAM4_API void Record(const TCHAR* Name, uint64 Cycles);
+
+	GP3_TEAM4_API void Reset();
+
+	GP3_TEAM4_API const TMap<const TCHAR*, FScopeStats>& GetStats();
+}
+
+class FGP3BenchmarkScope
+{
+public:
+	explicit FGP3BenchmarkScope(const TCHAR* InName)
+		: Name(GP3Benchmark::bIsRecording ? InName : nullptr)
+		, StartCycles(Name ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FGP3BenchmarkScope()
+	{
+		if (Name)
+		{
+			GP3Benchmark::Record(Name, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	const TCHAR* Name;
+	uint64 StartCycles;
+};
+
+#define GP3_BENCHMARK_SCOPE(Name) const FGP3BenchmarkScope ANONYMOUS_VARIABLE(GP3BenchmarkScope)(TEXT(Name))
+
+#else
+
+#define GP3_BENCHMARK_SCOPE(Name)
+
+#endif
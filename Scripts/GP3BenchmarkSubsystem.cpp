@@ -0,0 +1,302 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3BenchmarkSubsystem.h"
+#include "GP3Benchmark.h"
+#include "GP3Log.h"
+#include "Characters/PlayerCharacter.h"
+#include "Checkpoint/Checkpoint.h"
+#include "GameMode/QuestTankSubsystem.h"
+
+#include "EnhancedPlayerInput.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static FAutoConsoleCommandWithWorldAndArgs GP3BenchmarkCommand(
+	TEXT("gp3.Benchmark"),
+	TEXT("Runs the gameplay benchmark. Args: [Characters=32] [Frames=600] [quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGP3BenchmarkSubsystem* Benchmark = World ? World->GetSubsystem<UGP3BenchmarkSubsystem>() : nullptr;
+		if (!Benchmark || Benchmark->IsRunning()) return;
+
+		const int32 NumCharacters = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 32;
+		const int32 NumFrames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 600;
+		const bool bQuit = Args.Contains(TEXT("quit"));
+		Benchmark->StartBenchmark(FMath::Max(NumCharacters, 1), FMath::Max(NumFrames, 1), bQuit);
+	}));
+
+void UGP3BenchmarkSubsystem::StartBenchmark(int32 NumCharacters, int32 NumFrames, bool bInQuitWhenDone)
+{
+#if GP3_BENCHMARK_TIMING
+	SpawnScene(NumCharacters);
+	if (Characters.Num() == 0)
+	{
+		GP3_LOG(Error, TEXT("Benchmark could not spawn any player characters"));
+		if (bInQuitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+		return;
+	}
+
+	GP3Benchmark::Reset();
+	GP3Benchmark::bIsRecording = true;
+
+	FrameTimes.Reset(NumFrames);
+	FramesLeft = NumFrames;
+	Frame = 0;
+	LastFrameSeconds = FPlatformTime::Seconds();
+	bQuitWhenDone = bInQuitWhenDone;
+
+	GP3_LOG(Log, TEXT("Benchmark started: %d characters, %d frames"), Characters.Num(), NumFrames);
+#else
+	GP3_LOG(Warning, TEXT("Benchmark timing is compiled out of this build"));
+#endif
+}
+
+void UGP3BenchmarkSubsystem::Tick(float DeltaTime)
+{
+	if (!IsRunning()) return;
+
+	const double Now = FPlatformTime::Seconds();
+	if (Frame > 0)
+	{
+		FrameTimes.Add((Now - LastFrameSeconds) * 1000.0);
+	}
+	LastFrameSeconds = Now;
+
+	for (int32 Index = 0; Index < Characters.Num(); ++Index)
+	{
+		DriveInput(Index);
+	}
+
+	++Frame;
+	if (--FramesLeft == 0)
+	{
+		FinishBenchmark();
+	}
+}
+
+TStatId UGP3BenchmarkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGP3BenchmarkSubsystem, STATGROUP_Tickables);
+}
+
+void UGP3BenchmarkSubsystem::SpawnScene(int32 NumCharacters)
+{
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+
+	// the native class has no input actions assigned, so prefer the project's pawn blueprint
+	FString ClassPath;
+	UClass* PawnClass = nullptr;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-GP3BenchmarkPawn="), ClassPath))
+	{
+		PawnClass = LoadClass<APlayerCharacter>(nullptr, *ClassPath);
+	}
+	else if (GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf<APlayerCharacter>())
+	{
+		PawnClass = GameMode->DefaultPawnClass;
+	}
+
+	UClass* QuestTankClass = nullptr;
+	if (FParse::Value(FCommandLine::Get(), TEXT("-GP3BenchmarkQuestTank="), ClassPath))
+	{
+		QuestTankClass = LoadClass<AActor>(nullptr, *ClassPath);
+	}
+
+	// a dedicated server has no local players to inject input through
+	if (!PawnClass || !GameMode || World->GetNetMode() == NM_DedicatedServer) return;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleOtherwiseSpawnAnyway;
+
+	UQuestTankSubsystem* QuestTankSubsystem = World->GetSubsystem<UQuestTankSubsystem>();
+	const int32 GridWidth = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	const float Spacing = 400.f;
+
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		const FVector Location(Index % GridWidth * Spacing, Index / GridWidth * Spacing, 200.f);
+
+		APlayerCharacter* Character = World->SpawnActor<APlayerCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams);
+		if (!Character) continue;
+
+		// in a standalone game every player controller counts as local, so possessing
+		// runs SetupPlayerInputComponent and PawnClientRestart adds the mapping context
+		APlayerController* PlayerController = World->SpawnActor<APlayerController>(GameMode->PlayerControllerClass, SpawnParams);
+		if (!PlayerController)
+		{
+			Character->Destroy();
+			continue;
+		}
+		PlayerController->InitInputSystem();
+		PlayerController->Possess(Character);
+
+		Characters.Add(Character);
+		Controllers.Add(PlayerController);
+
+		if (QuestTankClass)
+		{
+			AActor* QuestTank = World->SpawnActor<AActor>(QuestTankClass, Location + FVector(150.f, 0.f, 0.f), FRotator::ZeroRotator, SpawnParams);
+			if (QuestTank && QuestTankSubsystem)
+			{
+				QuestTankSubsystem->RegisterQuestTank(QuestTank);
+			}
+			SceneActors.Add(QuestTank);
+		}
+
+		if (Index % 4 == 0)
+		{
+			SceneActors.Add(World->SpawnActor<ACheckpoint>(ACheckpoint::StaticClass(), Location + FVector(0.f, 200.f, 0.f), FRotator::ZeroRotator, SpawnParams));
+		}
+	}
+}
+
+void UGP3BenchmarkSubsystem::DriveInput(int32 CharacterIndex)
+{
+	APlayerCharacter* Character = Characters[CharacterIndex];
+	APlayerController* PlayerController = Controllers[CharacterIndex];
+	if (!Character || !PlayerController) return;
+
+	// stagger the characters so the same handlers don't all fire on the same frame
+	const int32 Step = Frame + CharacterIndex * 7;
+	const float Angle = Step * 0.05f;
+
+	InjectInput(PlayerController, Character->GetMoveAction(), FInputActionValue(FVector2D(FMath::Sin(Angle), FMath::Cos(Angle))));
+	InjectInput(PlayerController, Character->GetLookAction(), FInputActionValue(FVector2D(0.5f, 0.1f)));
+
+	if (Step % 20 == 0)
+	{
+		InjectInput(PlayerController, Character->GetAttackAction(), FInputActionValue(true));
+	}
+
+	// dash is bound to Completed, so a one-frame press fires it on the next frame
+	if (Step % 90 == 0)
+	{
+		InjectInput(PlayerController, Character->GetDashAction(), FInputActionValue(true));
+	}
+
+	const int32 Phase = Step % 120;
+	if (Phase < 30)
+	{
+		InjectInput(PlayerController, Character->GetQuestInteractAction(), FInputActionValue(true));
+	}
+	else if (Phase < 60)
+	{
+		InjectInput(PlayerController, Character->GetTransferAction(ECollectableType::ECT_Wind), FInputActionValue(true));
+	}
+	else if (Phase < 90)
+	{
+		InjectInput(PlayerController, Character->GetTransferAction(ECollectableType::ECT_Fire), FInputActionValue(true));
+	}
+	else
+	{
+		InjectInput(PlayerController, Character->GetTransferAction(ECollectableType::ECT_Earth), FInputActionValue(true));
+	}
+
+	if (Step % 10 == 0)
+	{
+		bool bIsCollectSuccess = false;
+		for (const ECollectableType Type : FElementPocket::Elements)
+		{
+			Character->GotCollectable(Type, 5, bIsCollectSuccess);
+		}
+	}
+}
+
+void UGP3BenchmarkSubsystem::InjectInput(APlayerController* PlayerController, const UInputAction* Action, const FInputActionValue& Value) const
+{
+	UEnhancedPlayerInput* PlayerInput = Cast<UEnhancedPlayerInput>(PlayerController->PlayerInput);
+	if (PlayerInput && Action)
+	{
+		PlayerInput->InjectInputForAction(Action, Value);
+	}
+}
+
+void UGP3BenchmarkSubsystem::FinishBenchmark()
+{
+#if GP3_BENCHMARK_TIMING
+	GP3Benchmark::bIsRecording = false;
+	WriteReport();
+#endif
+	DestroyScene();
+
+	if (bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UGP3BenchmarkSubsystem::WriteReport() const
+{
+#if GP3_BENCHMARK_TIMING
+	TArray<double> SortedFrameTimes = FrameTimes;
+	SortedFrameTimes.Sort();
+
+	auto Percentile = [&SortedFrameTimes](double Fraction)
+	{
+		if (SortedFrameTimes.Num() == 0) return 0.0;
+		return SortedFrameTimes[FMath::Clamp(FMath::FloorToInt((SortedFrameTimes.Num() - 1) * Fraction), 0, SortedFrameTimes.Num() - 1)];
+	};
+
+	FString Report = TEXT("metric,calls,total_ms,avg_us,max_us\n");
+	for (const TPair<const TCHAR*, GP3Benchmark::FScopeStats>& Pair : GP3Benchmark::GetStats())
+	{
+		const GP3Benchmark::FScopeStats& Stats = Pair.Value;
+		const double TotalMs = FPlatformTime::ToMilliseconds64(Stats.TotalCycles);
+		const double AverageUs = Stats.Calls > 0 ? TotalMs * 1000.0 / Stats.Calls : 0.0;
+		const double MaxUs = FPlatformTime::ToMilliseconds64(Stats.MaxCycles) * 1000.0;
+
+		Report += FString::Printf(TEXT("%s,%llu,%.3f,%.3f,%.3f\n"), Pair.Key, Stats.Calls, TotalMs, AverageUs, MaxUs);
+		GP3_LOG(Log, TEXT("Benchmark %-20s calls %8llu  avg %8.3f us  max %8.3f us"), Pair.Key, Stats.Calls, AverageUs, MaxUs);
+	}
+
+	Report += TEXT("\nframe_ms,p50,p90,p99,max\n");
+	Report += FString::Printf(TEXT("frame,%.3f,%.3f,%.3f,%.3f\n"), Percentile(0.5), Percentile(0.9), Percentile(0.99), Percentile(1.0));
+	GP3_LOG(Log, TEXT("Benchmark frame ms  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f"), Percentile(0.5), Percentile(0.9), Percentile(0.99), Percentile(1.0));
+
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("GameplayBenchmark.csv");
+	if (!FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		GP3_LOG(Warning, TEXT("Failed to write benchmark report to %s"), *ReportPath);
+	}
+#endif
+}
+
+void UGP3BenchmarkSubsystem::DestroyScene()
+{
+	UQuestTankSubsystem* QuestTankSubsystem = GetWorld()->GetSubsystem<UQuestTankSubsystem>();
+	for (AActor* Actor : SceneActors)
+	{
+		if (!Actor) continue;
+		if (QuestTankSubsystem)
+		{
+			QuestTankSubsystem->UnregisterQuestTank(Actor);
+		}
+		Actor->Destroy();
+	}
+	for (APlayerController* PlayerController : Controllers)
+	{
+		if (PlayerController)
+		{
+			PlayerController->UnPossess();
+			PlayerController->Destroy();
+		}
+	}
+	for (APlayerCharacter* Character : Characters)
+	{
+		if (Character)
+		{
+			Character->Destroy();
+		}
+	}
+
+	SceneActors.Reset();
+	Controllers.Reset();
+	Characters.Reset();
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GP3BenchmarkSubsystem.generated.h"
+
+class APlayerCharacter;
+class APlayerController;
+class UInputAction;
+struct FInputActionValue;
+
+/**
+ * Headless gameplay benchmark. Spawns player characters, quest tanks and checkpoints,
+ * drives the characters' input actions through Enhanced Input and reports per-function
+ * timings and frame-time percentiles to the log and Saved/Benchmarks.
+ *
+ * Run in a standalone game, e.g.
+ *   -game -nullrhi -unattended -ExecCmds="gp3.Benchmark 64 600 quit"
+ * Optional: -GP3BenchmarkPawn=<class path> -GP3BenchmarkQuestTank=<class path>
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3BenchmarkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	void StartBenchmark(int32 NumCharacters, int32 NumFrames, bool bQuitWhenDone);
+
+	bool IsRunning() const { return FramesLeft > 0; }
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	void SpawnScene(int32 NumCharacters);
+
+	void DriveInput(int32 CharacterIndex);
+
+	void InjectInput(APlayerController* PlayerController, const UInputAction* Action, const FInputActionValue& Value) const;
+
+	void FinishBenchmark();
+
+	void WriteReport() const;
+
+	void DestroyScene();
+
+	UPROPERTY()
+	TArray<APlayerCharacter*> Characters;
+
+	UPROPERTY()
+	TArray<APlayerController*> Controllers;
+
+	UPROPERTY()
+	TArray<AActor*> SceneActors;
+
+	TArray<double> FrameTimes;
+
+	int32 FramesLeft = 0;
+
+	int32 Frame = 0;
+
+	double LastFrameSeconds = 0.0;
+
+	bool bQuitWhenDone = false;
+};
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Components/GP3CharacterMovementComponent.h"
+
+#include "Curves/CurveFloat.h"
+#include "GameFramework/Character.h"
+
+void UGP3CharacterMovementComponent::StartDash(const FVector& Direction, float Distance, float Duration)
+{
+	DashStart = UpdatedComponent->GetComponentLocation();
+	DashDirection = FVector(Direction.X, Direction.Y, 0.f).GetSafeNormal();
+	DashDistance = Distance;
+	DashDuration = FMath::Max(Duration, KINDA_SMALL_NUMBER);
+	DashElapsed = 0.f;
+	bIsDashFromGround = IsMovingOnGround();
+
+	SetMovementMode(MOVE_Custom, CMOVE_Dash);
+}
+
+void UGP3CharacterMovementComponent::StopDash()
+{
+	if (!IsDashing()) return;
+
+	// walking drops into falling on its own if the dash ended over a ledge
+	SetDefaultMovementMode();
+}
+
+void UGP3CharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	if (CustomMovementMode == CMOVE_Dash)
+	{
+		PhysDash(deltaTime, Iterations);
+		return;
+	}
+
+	Super::PhysCustom(deltaTime, Iterations);
+}
+
+void UGP3CharacterMovementComponent::PhysDash(float DeltaTime, int32 Iterations)
+{
+	if (DeltaTime < MIN_TICK_TIME) return;
+
+	DashElapsed = FMath::Min(DashElapsed + DeltaTime, DashDuration);
+	const float Alpha = DashElapsed / DashDuration;
+
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const FVector Target = DashStart + DashDirection * (DashDistance * GetDashProgress(Alpha));
+	FVector Delta = Target - Location;
+	Delta.Z = 0.f;
+
+	// run along the floor so slopes are followed instead of left behind
+	if (bIsDashFromGround && CurrentFloor.IsWalkableFloor())
+	{
+		Delta = ComputeGroundMovementDelta(Delta, CurrentFloor.HitResult, CurrentFloor.bLineTrace);
+	}
+
+	// sweep with the capsule's own responses minus the ignored channel instead of changing its profile
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GP3DashSweep), false, CharacterOwner);
+	FCollisionResponseParams ResponseParams;
+	UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+	ResponseParams.CollisionResponse.SetResponse(DashIgnoredChannel, ECR_Ignore);
+
+	const FQuat Rotation = UpdatedComponent->GetComponentQuat();
+	const FCollisionShape Shape = UpdatedPrimitive->GetCollisionShape();
+
+	FHitResult Hit;
+	GetWorld()->SweepSingleByChannel(Hit, Location, Location + Delta, Rotation, UpdatedPrimitive->GetCollisionObjectType(), Shape, QueryParams, ResponseParams);
+
+	FVector Applied = Delta;
+	if (Hit.bStartPenetrating)
+	{
+		// started inside a blocker the dash doesn't pass through, push out and carry on next step
+		// rather than moving unswept through it
+		ResolvePenetration(GetPenetrationAdjustment(Hit), Hit, Rotation);
+		Applied = FVector::ZeroVector;
+	}
+	else if (Hit.bBlockingHit)
+	{
+		Applied = Delta * Hit.Time;
+
+		// slide along walls for the rest of this step
+		const FVector Slide = ComputeSlideVector(Delta, 1.f - Hit.Time, Hit.Normal, Hit);
+		FHitResult SlideHit;
+		GetWorld()->SweepSingleByChannel(SlideHit, Location + Applied, Location + Applied + Slide, Rotation, UpdatedPrimitive->GetCollisionObjectType(), Shape, QueryParams, ResponseParams);
+		Applied += SlideHit.bStartPenetrating ? FVector::ZeroVector : SlideHit.bBlockingHit ? Slide * SlideHit.Time : Slide;
+	}
+
+	FHitResult MoveHit;
+	MoveUpdatedComponent(Applied, Rotation, false, &MoveHit);
+	Velocity = Applied / DeltaTime;
+
+	if (bIsDashFromGround)
+	{
+		// step down onto the floor, a ground dash that runs off a ledge falls from there
+		FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, false);
+		if (!CurrentFloor.IsWalkableFloor())
+		{
+			Velocity.Z = 0.f;
+			SetMovementMode(MOVE_Falling);
+			return;
+		}
+		AdjustFloorHeight();
+	}
+
+	if (DashElapsed >= DashDuration)
+	{
+		StopDash();
+	}
+}
+
+float UGP3CharacterMovementComponent::GetDashProgress(float Alpha) const
+{
+	if (DashCurve)
+	{
+		return DashCurve->GetFloatValue(Alpha);
+	}
+	return 1.f - FMath::Square(1.f - Alpha);
+}
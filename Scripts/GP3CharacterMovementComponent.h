@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GP3CharacterMovementComponent.generated.h"
+
+class UCurveFloat;
+
+UENUM(BlueprintType)
+enum ECustomMovementMode
+{
+	CMOVE_None UMETA(Hidden),
+	CMOVE_Dash UMETA(DisplayName = "Dash"),
+	CMOVE_MAX UMETA(Hidden)
+};
+
+/**
+ * 
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3CharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	// Moves the character Distance along Direction over Duration, passing through DashIgnoredChannel
+	void StartDash(const FVector& Direction, float Distance, float Duration);
+
+	void StopDash();
+
+	UFUNCTION(BlueprintCallable)
+	bool IsDashing() const { return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Dash; }
+
+	// Fraction of the dash distance covered over normalized dash time, ease-out when unset
+	UPROPERTY(EditAnywhere, Category = "Dash")
+	UCurveFloat* DashCurve;
+
+	// Collision channel the dash sweep passes through, the capsule's own profile is left untouched
+	UPROPERTY(EditAnywhere, Category = "Dash")
+	TEnumAsByte<ECollisionChannel> DashIgnoredChannel = ECC_GameTraceChannel2;
+
+protected:
+
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+
+private:
+
+	void PhysDash(float DeltaTime, int32 Iterations);
+
+	float GetDashProgress(float Alpha) const;
+
+	FVector DashStart;
+	FVector DashDirection;
+	float DashDistance = 0.f;
+	float DashDuration = 0.f;
+	float DashElapsed = 0.f;
+
+	// ground dashes follow the floor and fall off ledges, air dashes keep their height
+	bool bIsDashFromGround = false;
+};
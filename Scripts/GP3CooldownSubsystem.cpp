@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3CooldownSubsystem.h"
+
+void UGP3CooldownSubsystem::StartCooldown(const UObject* Owner, FName CooldownId, float Duration, FOnCooldownExpired OnExpired)
+{
+	const int32 Index = FindCooldown(Owner, CooldownId);
+	if (Index != INDEX_NONE)
+	{
+		Remaining[Index] = Duration;
+		Callbacks[Index] = MoveTemp(OnExpired);
+		return;
+	}
+
+	const FCooldownKey Key{ FObjectKey(Owner), CooldownId };
+	IndexByKey.Add(Key, Remaining.Add(Duration));
+	Keys.Add(Key);
+	Callbacks.Add(MoveTemp(OnExpired));
+}
+
+void UGP3CooldownSubsystem::ClearCooldown(const UObject* Owner, FName CooldownId)
+{
+	const int32 Index = FindCooldown(Owner, CooldownId);
+	if (Index != INDEX_NONE)
+	{
+		RemoveCooldownAt(Index);
+	}
+}
+
+void UGP3CooldownSubsystem::ClearCooldowns(const UObject* Owner)
+{
+	const FObjectKey OwnerKey(Owner);
+	for (int32 Index = Keys.Num() - 1; Index >= 0; --Index)
+	{
+		if (Keys[Index].Owner == OwnerKey)
+		{
+			RemoveCooldownAt(Index);
+		}
+	}
+}
+
+float UGP3CooldownSubsystem::GetRemaining(const UObject* Owner, FName CooldownId) const
+{
+	const int32 Index = FindCooldown(Owner, CooldownId);
+	return Index != INDEX_NONE ? Remaining[Index] : 0.f;
+}
+
+void UGP3CooldownSubsystem::Tick(float DeltaTime)
+{
+	const int32 Num = Remaining.Num();
+	float* RemainingData = Remaining.GetData();
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		RemainingData[Index] -= DeltaTime;
+	}
+
+	for (int32 Index = Num - 1; Index >= 0; --Index)
+	{
+		if (RemainingData[Index] <= 0.f)
+		{
+			ExpiredCallbacks.Add(MoveTemp(Callbacks[Index]));
+			RemoveCooldownAt(Index);
+		}
+	}
+
+	// callbacks run once the arrays are consistent, they are free to start new cooldowns
+	for (FOnCooldownExpired& Callback : ExpiredCallbacks)
+	{
+		Callback.ExecuteIfBound();
+	}
+	ExpiredCallbacks.Reset();
+}
+
+TStatId UGP3CooldownSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGP3CooldownSubsystem, STATGROUP_Tickables);
+}
+
+int32 UGP3CooldownSubsystem::FindCooldown(const UObject* Owner, FName CooldownId) const
+{
+	const int32* Index = IndexByKey.Find({ FObjectKey(Owner), CooldownId });
+	return Index ? *Index : INDEX_NONE;
+}
+
+void UGP3CooldownSubsystem::RemoveCooldownAt(int32 Index)
+{
+	IndexByKey.Remove(Keys[Index]);
+	const int32 LastIndex = Keys.Num() - 1;
+	if (Index != LastIndex)
+	{
+		// the last entry is swapped into the freed slot
+		IndexByKey[Keys[LastIndex]] = Index;
+	}
+
+	Remaining.RemoveAtSwap(Index, 1, false);
+	Keys.RemoveAtSwap(Index, 1, false);
+	Callbacks.RemoveAtSwap(Index, 1, false);
+}
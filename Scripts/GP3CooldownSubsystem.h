@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "GP3CooldownSubsystem.generated.h"
+
+DECLARE_DELEGATE(FOnCooldownExpired);
+
+/**
+ * Cooldowns and ability timers for every character in the world, kept in flat arrays
+ * and advanced in one pass per frame instead of one timer-manager handle per timer.
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3CooldownSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Starts or restarts the cooldown, OnExpired runs once it has elapsed
+	void StartCooldown(const UObject* Owner, FName CooldownId, float Duration, FOnCooldownExpired OnExpired = FOnCooldownExpired());
+
+	// Removes the cooldown without running its expiry callback
+	void ClearCooldown(const UObject* Owner, FName CooldownId);
+
+	void ClearCooldowns(const UObject* Owner);
+
+	UFUNCTION(BlueprintCallable)
+	bool IsReady(const UObject* Owner, FName CooldownId) const { return FindCooldown(Owner, CooldownId) == INDEX_NONE; }
+
+	UFUNCTION(BlueprintCallable)
+	float GetRemaining(const UObject* Owner, FName CooldownId) const;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	struct FCooldownKey
+	{
+		FObjectKey Owner;
+		FName CooldownId;
+
+		bool operator==(const FCooldownKey& Other) const { return Owner == Other.Owner && CooldownId == Other.CooldownId; }
+		friend uint32 GetTypeHash(const FCooldownKey& Key) { return HashCombine(GetTypeHash(Key.Owner), GetTypeHash(Key.CooldownId)); }
+	};
+
+	int32 FindCooldown(const UObject* Owner, FName CooldownId) const;
+
+	void RemoveCooldownAt(int32 Index);
+
+	// Parallel arrays, the per-frame pass only walks Remaining
+	TArray<float> Remaining;
+	TArray<FCooldownKey> Keys;
+	TArray<FOnCooldownExpired> Callbacks;
+
+	// Slot of each key in the parallel arrays, kept in step with RemoveAtSwap
+	TMap<FCooldownKey, int32> IndexByKey;
+
+	TArray<FOnCooldownExpired> ExpiredCallbacks;
+};
@@ -2,6 +2,118 @@
 
 
 #include "GP3GameInstance.h"
+#include "GP3Log.h"
+#include "Checkpoint/Checkpoint.h"
+#include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
 
+void UGP3GameInstance::Init()
+{
+	Super::Init();
 
+	CheckpointSaveGame = Cast<UGP3SaveGame>(UGameplayStatics::CreateSaveGameObject(UGP3SaveGame::StaticClass()));
 
+	if (UGameplayStatics::DoesSaveGameExist(CheckpointSaveSlot, 0))
+	{
+		UGameplayStatics::AsyncLoadGameFromSlot(CheckpointSaveSlot, 0,
+			FAsyncLoadGameFromSlotDelegate::CreateUObject(this, &UGP3GameInstance::OnCheckpointLoaded));
+	}
+}
+
+bool UGP3GameInstance::ActivateCheckpoint(FName CheckpointId, int32 CheckpointOrder, FVector Location, APlayerCharacter* PlayerCharacter)
+{
+	if (CheckpointId == CurrentCheckpointId || CheckpointOrder < CurrentCheckpointOrder) return false;
+
+	CurrentCheckpointId = CheckpointId;
+	CurrentCheckpointOrder = CheckpointOrder;
+	CurrentCheckpointLocation = Location;
+	if (PlayerCharacter)
+	{
+		PlayerCharacter->CaptureProgress(CheckpointProgress);
+	}
+
+	SaveCheckpointAsync();
+	return true;
+}
+
+bool UGP3GameInstance::RespawnAtCheckpoint(APlayerCharacter* PlayerCharacter)
+{
+	if (!PlayerCharacter || CurrentCheckpointId.IsNone()) return false;
+
+	PlayerCharacter->RespawnInPlace(CurrentCheckpointLocation, CheckpointProgress);
+	return true;
+}
+
+void UGP3GameInstance::SetStreamingCheckpoint(ACheckpoint* Checkpoint)
+{
+	if (!Checkpoint || StreamingCheckpoint == Checkpoint) return;
+
+	Checkpoint->PinStreaming();
+	if (ACheckpoint* PreviousCheckpoint = StreamingCheckpoint.Get())
+	{
+		PreviousCheckpoint->UnpinStreaming(Checkpoint);
+	}
+	StreamingCheckpoint = Checkpoint;
+}
+
+void UGP3GameInstance::SaveCheckpointAsync()
+{
+	// only one write in flight, activations that land meanwhile are folded into the next one
+	if (bIsSaving)
+	{
+		bSaveQueued = true;
+		return;
+	}
+
+	CheckpointSaveGame->CheckpointId = CurrentCheckpointId;
+	CheckpointSaveGame->CheckpointOrder = CurrentCheckpointOrder;
+	CheckpointSaveGame->CheckpointLocation = CurrentCheckpointLocation;
+	CheckpointSaveGame->PlayerProgress = CheckpointProgress;
+
+	bIsSaving = true;
+	UGameplayStatics::AsyncSaveGameToSlot(CheckpointSaveGame, CheckpointSaveSlot, 0,
+		FAsyncSaveGameToSlotDelegate::CreateUObject(this, &UGP3GameInstance::OnCheckpointSaved));
+}
+
+void UGP3GameInstance::OnCheckpointSaved(const FString& SlotName, const int32 UserIndex, bool bSuccess)
+{
+	bIsSaving = false;
+
+	if (!bSuccess)
+	{
+		GP3_LOG(Warning, TEXT("Failed to save checkpoint to slot %s"), *SlotName);
+	}
+
+	if (bSaveQueued)
+	{
+		bSaveQueued = false;
+		SaveCheckpointAsync();
+	}
+}
+
+void UGP3GameInstance::OnCheckpointLoaded(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGame)
+{
+	UGP3SaveGame* LoadedSaveGame = Cast<UGP3SaveGame>(SaveGame);
+
+	// a checkpoint activated before the load finished is newer than what's on disk
+	if (!LoadedSaveGame || !CurrentCheckpointId.IsNone()) return;
+
+	CheckpointSaveGame = LoadedSaveGame;
+	CurrentCheckpointId = LoadedSaveGame->CheckpointId;
+	CurrentCheckpointOrder = LoadedSaveGame->CheckpointOrder;
+	CurrentCheckpointLocation = LoadedSaveGame->CheckpointLocation;
+	CheckpointProgress = LoadedSaveGame->PlayerProgress;
+
+	// checkpoints that begin play later pin themselves when they see their id is current
+	if (UWorld* World = GetWorld())
+	{
+		for (TActorIterator<ACheckpoint> It(World); It; ++It)
+		{
+			if (It->GetCheckpointId() == CurrentCheckpointId)
+			{
+				SetStreamingCheckpoint(*It);
+				break;
+			}
+		}
+	}
+}
@@ -5,8 +5,11 @@
 #include "CoreMinimal.h"
 #include "Engine/GameInstance.h"
 #include "Characters/PlayerCharacter.h"
+#include "GP3SaveGame.h"
 #include "GP3GameInstance.generated.h"
 
+class USaveGame;
+class ACheckpoint;
 
 /**
  * 
@@ -17,6 +20,8 @@ class GP3_TEAM4_API UGP3GameInstance : public UGameInstance
 	GENERATED_BODY()
 
 public:
+
+	virtual void Init() override;
 	
 	UFUNCTION(BlueprintCallable)
 	FVector GetCurrentCheckpointLocation() const { return CurrentCheckpointLocation; }
@@ -24,10 +29,51 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void SetCurrentCheckpointLocation(FVector Location) { CurrentCheckpointLocation = Location; }
 
+	UFUNCTION(BlueprintCallable)
+	FName GetCurrentCheckpointId() const { return CurrentCheckpointId; }
+
+	const FPlayerProgress& GetCheckpointProgress() const { return CheckpointProgress; }
+
+	// Records the checkpoint and the player's progress, then writes them to the save slot in the background.
+	// Returns false without doing anything if the checkpoint is already active or behind the current one.
+	UFUNCTION(BlueprintCallable)
+	bool ActivateCheckpoint(FName CheckpointId, int32 CheckpointOrder, FVector Location, APlayerCharacter* PlayerCharacter);
+
+	// Puts the existing pawn back at the current checkpoint with the progress it had there.
+	// Returns false if no checkpoint has been reached yet.
+	UFUNCTION(BlueprintCallable)
+	bool RespawnAtCheckpoint(APlayerCharacter* PlayerCharacter);
+
+	UPROPERTY(EditDefaultsOnly, Category = "Save")
+	FString CheckpointSaveSlot = TEXT("Checkpoint");
+
+	// Pins the checkpoint's streaming content and releases what the previous one pinned
+	void SetStreamingCheckpoint(ACheckpoint* Checkpoint);
+
 private:
 
+	void SaveCheckpointAsync();
+
+	void OnCheckpointSaved(const FString& SlotName, const int32 UserIndex, bool bSuccess);
+
+	void OnCheckpointLoaded(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGame);
+
 	APlayerCharacter* Player;
 	
 	FVector CurrentCheckpointLocation;
+
+	FName CurrentCheckpointId;
+
+	int32 CurrentCheckpointOrder = MIN_int32;
+
+	FPlayerProgress CheckpointProgress;
+
+	TWeakObjectPtr<ACheckpoint> StreamingCheckpoint;
+
+	UPROPERTY()
+	UGP3SaveGame* CheckpointSaveGame;
+
+	bool bIsSaving = false;
+	bool bSaveQueued = false;
 	
 };
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3Log.h"
+
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY(LogGP3Gameplay);
+
+#if GP3_GAMEPLAY_LOGGING
+
+namespace GP3Log
+{
+	// set-associative call-site table, a key only loses its slot once every way of its set
+	// is taken by keys that logged more recently, so a handful of sites or objects that
+	// hash alike are still throttled independently
+	struct FLogSlot
+	{
+		uint64 Key = 0;
+		double ThrottledUntil = -DBL_MAX;
+	};
+	static constexpr int32 NumLogSets = 64;
+	static constexpr int32 NumLogWays = 4;
+	static FLogSlot LogSlots[NumLogSets][NumLogWays];
+	static FCriticalSection LogSlotsLock;
+
+	uint64 MakeKey(const ANSICHAR* File, int32 Line, const void* Context)
+	{
+		const uint64 SiteHash = (static_cast<uint64>(PointerHash(File)) << 32) | static_cast<uint32>(Line);
+		return SiteHash ^ (static_cast<uint64>(PointerHash(Context)) * 0x9E3779B97F4A7C15ull);
+	}
+
+	bool ShouldLog(uint64 Key, float Interval)
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		FScopeLock Lock(&LogSlotsLock);
+		FLogSlot* Set = LogSlots[(Key ^ (Key >> 32)) & (NumLogSets - 1)];
+
+		// reuse the key's own way, otherwise take the one whose throttle ends first
+		FLogSlot* Slot = &Set[0];
+		for (int32 Way = 0; Way < NumLogWays; ++Way)
+		{
+			if (Set[Way].Key == Key)
+			{
+				Slot = &Set[Way];
+				break;
+			}
+			if (Set[Way].ThrottledUntil < Slot->ThrottledUntil)
+			{
+				Slot = &Set[Way];
+			}
+		}
+
+		if (Slot->Key == Key && Now < Slot->ThrottledUntil) return false;
+
+		Slot->Key = Key;
+		Slot->ThrottledUntil = Now + Interval;
+		return true;
+	}
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+GP3_TEAM4_API DECLARE_LOG_CATEGORY_EXTERN(LogGP3Gameplay, Log, All);
+
+// Gameplay logging is stripped from Shipping and Test builds
+#define GP3_GAMEPLAY_LOGGING !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+
+#if GP3_GAMEPLAY_LOGGING
+
+namespace GP3Log
+{
+	// Identifies a log call site, optionally per object, so repeats can be recognised
+	GP3_TEAM4_API uint64 MakeKey(const ANSICHAR* File, int32 Line, const void* Context);
+
+	// Returns false if the same key already logged less than Interval seconds ago
+	GP3_TEAM4_API bool ShouldLog(uint64 Key, float Interval);
+}
+
+#define GP3_LOG(Verbosity, Format, ...) \
+	UE_LOG(LogGP3Gameplay, Verbosity, Format, ##__VA_ARGS__)
+
+// Logs at most once every Interval seconds per call site and Context object
+#define GP3_LOG_THROTTLED(Context, Interval, Verbosity, Format, ...) \
+	do \
+	{ \
+		if (GP3Log::ShouldLog(GP3Log::MakeKey(__FILE__, __LINE__, Context), Interval)) \
+		{ \
+			UE_LOG(LogGP3Gameplay, Verbosity, Format, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+// Repeats from the same call site and Context replace the previous message instead of stacking
+#define GP3_SCREEN_MESSAGE(Context, Duration, Color, Message) \
+	do \
+	{ \
+		if (GEngine) \
+		{ \
+			GEngine->AddOnScreenDebugMessage(static_cast<int32>(GP3Log::MakeKey(__FILE__, __LINE__, Context) & MAX_int32), Duration, Color, Message); \
+		} \
+	} while (0)
+
+#else
+
+#define GP3_LOG(Verbosity, Format, ...) do {} while (0)
+#define GP3_LOG_THROTTLED(Context, Interval, Verbosity, Format, ...) do {} while (0)
+#define GP3_SCREEN_MESSAGE(Context, Duration, Color, Message) do {} while (0)
+
+#endif
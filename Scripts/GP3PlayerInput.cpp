@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3PlayerInput.h"
+
+bool UGP3PlayerInput::InputKey(const FInputKeyParams& Params)
+{
+	if (bIsReplaying) return false;
+
+	OnInputKey.Broadcast(Params);
+	return Super::InputKey(Params);
+}
+
+bool UGP3PlayerInput::InjectKey(const FInputKeyParams& Params)
+{
+	return Super::InputKey(Params);
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnhancedPlayerInput.h"
+#include "GP3PlayerInput.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnGP3InputKey, const FInputKeyParams&);
+
+/**
+ * Enhanced player input that reports every raw key event it receives, so a recording keeps
+ * presses and releases that happen within a single frame. While a replay drives the player,
+ * hardware input is dropped and only injected events get through.
+ * Set as DefaultPlayerInputClass in DefaultInput.ini.
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3PlayerInput : public UEnhancedPlayerInput
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual bool InputKey(const FInputKeyParams& Params) override;
+
+	// Feeds a recorded event to the player input, bypassing the replay block
+	bool InjectKey(const FInputKeyParams& Params);
+
+	FOnGP3InputKey OnInputKey;
+
+	bool bIsReplaying = false;
+};
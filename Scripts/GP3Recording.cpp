@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3Recording.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+namespace GP3Recording
+{
+	void WriteVarUInt(TArray<uint8>& Out, uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Out.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+		Out.Add(static_cast<uint8>(Value));
+	}
+
+	void WriteVarInt(TArray<uint8>& Out, int32 Value)
+	{
+		// zigzag keeps small negative deltas small
+		WriteVarUInt(Out, (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31));
+	}
+
+	void WriteString(TArray<uint8>& Out, const FString& Value)
+	{
+		const FTCHARToUTF8 Utf8(*Value);
+		WriteVarUInt(Out, Utf8.Length());
+		Out.Append(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	}
+
+	bool ReadVarUInt(const uint8*& Cursor, const uint8* End, uint32& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			if (Cursor >= End) return false;
+
+			const uint8 Byte = *Cursor++;
+			OutValue |= static_cast<uint32>(Byte & 0x7f) << Shift;
+			if (!(Byte & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool ReadVarInt(const uint8*& Cursor, const uint8* End, int32& OutValue)
+	{
+		uint32 Encoded;
+		if (!ReadVarUInt(Cursor, End, Encoded)) return false;
+
+		OutValue = static_cast<int32>(Encoded >> 1) ^ -static_cast<int32>(Encoded & 1);
+		return true;
+	}
+
+	bool ReadString(const uint8*& Cursor, const uint8* End, FString& OutValue)
+	{
+		uint32 Length;
+		if (!ReadVarUInt(Cursor, End, Length) || End - Cursor < static_cast<int64>(Length)) return false;
+
+		const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Cursor), Length);
+		OutValue = FString(Converted.Length(), Converted.Get());
+		Cursor += Length;
+		return true;
+	}
+
+	FWriter::FWriter(FArchive* InFile)
+		: File(InFile)
+		, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+		, bIsClosing(false)
+	{
+		Thread = FRunnableThread::Create(this, TEXT("GP3RecordingWriter"), 0, TPri_BelowNormal);
+	}
+
+	FWriter::~FWriter()
+	{
+		Close();
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	}
+
+	void FWriter::Enqueue(TArray<uint8>&& Chunk)
+	{
+		if (Chunk.Num() == 0) return;
+
+		Pending.Enqueue(MoveTemp(Chunk));
+		WorkEvent->Trigger();
+	}
+
+	void FWriter::Close()
+	{
+		if (!Thread) return;
+
+		bIsClosing = true;
+		WorkEvent->Trigger();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+
+		delete File;
+		File = nullptr;
+	}
+
+	uint32 FWriter::Run()
+	{
+		while (!bIsClosing)
+		{
+			WorkEvent->Wait();
+			WritePending();
+		}
+
+		// chunks enqueued right before closing
+		WritePending();
+		File->Flush();
+		return 0;
+	}
+
+	void FWriter::WritePending()
+	{
+		TArray<uint8> Chunk;
+		while (Pending.Dequeue(Chunk))
+		{
+			File->Serialize(Chunk.GetData(), Chunk.Num());
+		}
+	}
+}
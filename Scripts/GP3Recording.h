@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Binary format of gameplay recordings. A header with the recorded key names and value sizes is
+ * followed by records of [varint frame delta][kind][payload]. Keys are recorded raw, before
+ * any mapping or action modifiers, one input record per key event in the order they arrived,
+ * so a press and release within one frame are both kept. An input record holds the key index
+ * and the EInputEvent, axis events add their sample count and their value per component as
+ * zigzag varint deltas of 1/1024 fixed point against the previous value of the same key, so a
+ * slowly changing stick costs a few bytes. Every frame also records its delta time in
+ * microseconds, as a zigzag delta against the previous frame's.
+ */
+namespace GP3Recording
+{
+	static constexpr uint32 Magic = 0x52335047; // "GP3R"
+	static constexpr uint16 Version = 3;
+	static constexpr float ValueScale = 1024.f;
+	static constexpr int32 MaxValueComponents = 3;
+
+	enum class ERecordKind : uint8
+	{
+		Input,
+		Collectable,
+		TransferStart,
+		TransferStop,
+		Dash,
+		ComboStep,
+		Checkpoint,
+		FrameTime,
+		End
+	};
+
+	GP3_TEAM4_API void WriteVarUInt(TArray<uint8>& Out, uint32 Value);
+	GP3_TEAM4_API void WriteVarInt(TArray<uint8>& Out, int32 Value);
+	GP3_TEAM4_API void WriteString(TArray<uint8>& Out, const FString& Value);
+
+	// Readers return false once the cursor would run past End
+	GP3_TEAM4_API bool ReadVarUInt(const uint8*& Cursor, const uint8* End, uint32& OutValue);
+	GP3_TEAM4_API bool ReadVarInt(const uint8*& Cursor, const uint8* End, int32& OutValue);
+	GP3_TEAM4_API bool ReadString(const uint8*& Cursor, const uint8* End, FString& OutValue);
+
+	/**
+	 * Appends chunks handed over from the game thread to a file on its own thread,
+	 * the game thread never waits on disk.
+	 */
+	class GP3_TEAM4_API FWriter : public FRunnable
+	{
+	public:
+		explicit FWriter(FArchive* InFile);
+		virtual ~FWriter() override;
+
+		// Takes ownership of the chunk and wakes the writer thread
+		void Enqueue(TArray<uint8>&& Chunk);
+
+		// Writes what is still queued and closes the file, blocks until done
+		void Close();
+
+		virtual uint32 Run() override;
+
+	private:
+		void WritePending();
+
+		FArchive* File;
+		TQueue<TArray<uint8>, EQueueMode::Spsc> Pending;
+		FEvent* WorkEvent;
+		FRunnableThread* Thread;
+		TAtomic<bool> bIsClosing;
+	};
+}
@@ -0,0 +1,686 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3ReplaySubsystem.h"
+#include "GP3Log.h"
+#include "GP3PlayerInput.h"
+#include "Characters/PlayerCharacter.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+using namespace GP3Recording;
+
+// Chunks smaller than this stay on the game thread until the next frame
+static constexpr int32 RecordingChunkSize = 4096;
+
+static FAutoConsoleCommandWithWorldAndArgs GP3RecordStartCommand(
+	TEXT("gp3.Record.Start"),
+	TEXT("Records the local player's input and gameplay events. Args: [File=Session.gp3rec]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGP3ReplaySubsystem* Replay = World ? World->GetSubsystem<UGP3ReplaySubsystem>() : nullptr)
+		{
+			Replay->StartRecording(Args.Num() > 0 ? Args[0] : TEXT("Session.gp3rec"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GP3RecordStopCommand(
+	TEXT("gp3.Record.Stop"),
+	TEXT("Stops the running recording"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGP3ReplaySubsystem* Replay = World ? World->GetSubsystem<UGP3ReplaySubsystem>() : nullptr)
+		{
+			Replay->StopRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GP3ReplayCommand(
+	TEXT("gp3.Replay"),
+	TEXT("Plays a recording back on the local player. Args: File [quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGP3ReplaySubsystem* Replay = World ? World->GetSubsystem<UGP3ReplaySubsystem>() : nullptr;
+		if (!Replay || Args.Num() == 0) return;
+
+		Replay->StartReplay(Args[0], Args.Contains(TEXT("quit")));
+	}));
+
+bool UGP3ReplaySubsystem::StartRecording(const FString& FileName)
+{
+	if (IsRecording() || IsReplaying()) return false;
+
+	Character = FindLocalCharacter();
+	if (!Character || !SetupKeys(Character))
+	{
+		GP3_LOG(Warning, TEXT("Recording needs a locally controlled player character with UGP3PlayerInput"));
+		return false;
+	}
+
+	const FString Path = GetRecordingPath(FileName);
+	FArchive* File = IFileManager::Get().CreateFileWriter(*Path);
+	if (!File)
+	{
+		GP3_LOG(Warning, TEXT("Failed to open recording %s"), *Path);
+		return false;
+	}
+
+	Chunk.Reset();
+	Chunk.Append(reinterpret_cast<const uint8*>(&Magic), sizeof(Magic));
+	Chunk.Append(reinterpret_cast<const uint8*>(&Version), sizeof(Version));
+	WriteVarUInt(Chunk, Keys.Num());
+	for (const FRecordedKey& RecordedKey : Keys)
+	{
+		WriteString(Chunk, RecordedKey.Key.GetFName().ToString());
+		Chunk.Add(static_cast<uint8>(RecordedKey.NumComponents));
+	}
+
+	Writer = MakeUnique<FWriter>(File);
+	Frame = 0;
+	LastRecordFrame = 0;
+	LastFrameMicroseconds = 0;
+	InputKeyHandle = GetPlayerInput()->OnInputKey.AddUObject(this, &UGP3ReplaySubsystem::OnInputKey);
+
+	GP3_LOG(Log, TEXT("Recording to %s"), *Path);
+	return true;
+}
+
+void UGP3ReplaySubsystem::StopRecording()
+{
+	if (!IsRecording()) return;
+
+	if (UGP3PlayerInput* PlayerInput = IsValid(Character) ? GetPlayerInput() : nullptr)
+	{
+		PlayerInput->OnInputKey.Remove(InputKeyHandle);
+	}
+	InputKeyHandle.Reset();
+
+	BeginRecord(ERecordKind::End);
+	Writer->Enqueue(MoveTemp(Chunk));
+	Writer->Close();
+	Writer.Reset();
+
+	GP3_LOG(Log, TEXT("Recording stopped after %u frames"), Frame);
+}
+
+bool UGP3ReplaySubsystem::StartReplay(const FString& FileName, bool bInQuitWhenDone)
+{
+	if (IsRecording() || IsReplaying()) return false;
+
+	const FString Path = GetRecordingPath(FileName);
+	TArray<uint8> Data;
+	Character = FindLocalCharacter();
+	if (!Character || !GetPlayerInput() || !FFileHelper::LoadFileToArray(Data, *Path))
+	{
+		GP3_LOG(Warning, TEXT("Could not replay %s"), *Path);
+		return false;
+	}
+
+	const uint8* Cursor = Data.GetData();
+	const uint8* End = Cursor + Data.Num();
+	uint32 FileMagic = 0;
+	uint16 FileVersion = 0;
+	if (Data.Num() < sizeof(FileMagic) + sizeof(FileVersion)) return false;
+	FMemory::Memcpy(&FileMagic, Cursor, sizeof(FileMagic));
+	FMemory::Memcpy(&FileVersion, Cursor + sizeof(FileMagic), sizeof(FileVersion));
+	Cursor += sizeof(FileMagic) + sizeof(FileVersion);
+	if (FileMagic != Magic || FileVersion != Version)
+	{
+		GP3_LOG(Warning, TEXT("%s is not a version %d recording"), *Path, Version);
+		return false;
+	}
+
+	// keys are looked up by name, unknown ones are read but never injected
+	uint32 NumRecordedKeys;
+	if (!ReadVarUInt(Cursor, End, NumRecordedKeys)) return false;
+
+	Keys.Reset();
+	for (uint32 Index = 0; Index < NumRecordedKeys; ++Index)
+	{
+		FString KeyName;
+		if (!ReadString(Cursor, End, KeyName) || Cursor >= End) return false;
+
+		FRecordedKey& RecordedKey = Keys.AddDefaulted_GetRef();
+		RecordedKey.Key = FKey(FName(*KeyName));
+		RecordedKey.NumComponents = FMath::Clamp<int32>(*Cursor++, 1, MaxValueComponents);
+	}
+
+	// frame times are needed a frame ahead, so they are all read up front
+	FrameDeltas.Reset();
+	{
+		const uint8* ScanCursor = Cursor;
+		uint32 ScanFrame = 0;
+		int32 Microseconds = 0;
+		FRecord Record;
+		while (ReadRecord(ScanCursor, End, Record) && Record.Kind != ERecordKind::End)
+		{
+			ScanFrame += Record.FrameDelta;
+			if (Record.Kind != ERecordKind::FrameTime) continue;
+
+			Microseconds += Record.Number;
+			if (FrameDeltas.Num() <= static_cast<int32>(ScanFrame))
+			{
+				FrameDeltas.SetNumZeroed(ScanFrame + 1);
+			}
+			FrameDeltas[ScanFrame] = Microseconds / 1000000.f;
+		}
+	}
+
+	ReplayData = MoveTemp(Data);
+	ReplayOffset = Cursor - ReplayData.GetData();
+	NextRecordFrame = 0;
+	Frame = 0;
+	bHasReachedEnd = false;
+	bQuitWhenDone = bInQuitWhenDone;
+	ExpectedEvents.Reset();
+	NumMatchedEvents = 0;
+	NumDivergences = 0;
+
+	GetPlayerInput()->bIsReplaying = true;
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UGP3ReplaySubsystem::OnWorldTickStart);
+
+	// recorded step and no frame rate cap, so every replay of the file sees the same frames
+	FApp::SetBenchmarking(true);
+	FApp::SetFixedDeltaTime(FrameDeltas.Num() > 0 && FrameDeltas[0] > 0.f ? FrameDeltas[0] : 1.0 / 60.0);
+	ReplayStartSeconds = FPlatformTime::Seconds();
+
+	GP3_LOG(Log, TEXT("Replaying %s, %d frames"), *Path, FrameDeltas.Num());
+	return true;
+}
+
+void UGP3ReplaySubsystem::RecordCollectable(const AActor* Instigator, ECollectableType Type, int32 Value)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::Collectable;
+	Record.Type = static_cast<uint8>(Type);
+	Record.Number = Value;
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::RecordTransferStart(const AActor* Instigator, ECollectableType Type)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::TransferStart;
+	Record.Type = static_cast<uint8>(Type);
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::RecordTransferStop(const AActor* Instigator)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::TransferStop;
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::RecordDash(const AActor* Instigator)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::Dash;
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::RecordComboStep(const AActor* Instigator, int32 ComboStep)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::ComboStep;
+	Record.Number = ComboStep;
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::RecordCheckpoint(const AActor* Instigator, FName CheckpointId, int32 CheckpointOrder)
+{
+	FRecord Record;
+	Record.Kind = ERecordKind::Checkpoint;
+	Record.Name = CheckpointId.ToString();
+	Record.Number = CheckpointOrder;
+	RecordEvent(Instigator, Record);
+}
+
+void UGP3ReplaySubsystem::Tick(float DeltaTime)
+{
+	if (IsRecording())
+	{
+		if (!IsValid(Character))
+		{
+			StopRecording();
+			return;
+		}
+
+		RecordFrameTime();
+		if (Chunk.Num() >= RecordingChunkSize)
+		{
+			Writer->Enqueue(MoveTemp(Chunk));
+			Chunk.Reserve(RecordingChunkSize * 2);
+		}
+		++Frame;
+	}
+	else if (IsReplaying())
+	{
+		if (!IsValid(Character))
+		{
+			FinishReplay();
+			return;
+		}
+
+		// records due before the first tick start, e.g. in the frame the replay started
+		ReplayFrame();
+		CheckMissingEvents(Frame);
+		if (bHasReachedEnd)
+		{
+			FinishReplay();
+			return;
+		}
+
+		if (FrameDeltas.IsValidIndex(Frame + 1) && FrameDeltas[Frame + 1] > 0.f)
+		{
+			FApp::SetFixedDeltaTime(FrameDeltas[Frame + 1]);
+		}
+		++Frame;
+	}
+}
+
+TStatId UGP3ReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGP3ReplaySubsystem, STATGROUP_Tickables);
+}
+
+void UGP3ReplaySubsystem::Deinitialize()
+{
+	StopRecording();
+	if (IsReplaying())
+	{
+		FinishReplay();
+	}
+
+	Super::Deinitialize();
+}
+
+APlayerCharacter* UGP3ReplaySubsystem::FindLocalCharacter() const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController ? Cast<APlayerCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+UGP3PlayerInput* UGP3ReplaySubsystem::GetPlayerInput() const
+{
+	const APlayerController* PlayerController = Character ? Cast<APlayerController>(Character->GetController()) : nullptr;
+	return PlayerController ? Cast<UGP3PlayerInput>(PlayerController->PlayerInput) : nullptr;
+}
+
+bool UGP3ReplaySubsystem::SetupKeys(APlayerCharacter* InCharacter)
+{
+	const UGP3PlayerInput* PlayerInput = GetPlayerInput();
+	if (!PlayerInput) return false;
+
+	TArray<UInputAction*> CharacterActions;
+	InCharacter->GetRecordedActions(CharacterActions);
+
+	TArray<FKey> MappedKeys;
+	for (const FEnhancedActionKeyMapping& Mapping : PlayerInput->GetEnhancedActionMappings())
+	{
+		if (Mapping.Key.IsValid() && CharacterActions.Contains(Mapping.Action))
+		{
+			MappedKeys.AddUnique(Mapping.Key);
+		}
+	}
+
+	// 2D axes such as Mouse2D arrive as their paired 1D axes, those are the events to record
+	TArray<FKey> AllKeys;
+	EKeys::GetAllKeys(AllKeys);
+	for (const FKey& Key : AllKeys)
+	{
+		if (Key.GetPairedAxis() != EPairedAxis::Unpaired && MappedKeys.Contains(Key.GetPairedAxisKey()))
+		{
+			MappedKeys.AddUnique(Key);
+		}
+	}
+
+	// raw keys, so replay goes through the same mappings and modifiers as the recorded session
+	Keys.Reset();
+	for (const FKey& Key : MappedKeys)
+	{
+		// key indices are written as a byte
+		if (Keys.Num() > MAX_uint8)
+		{
+			GP3_LOG(Warning, TEXT("Recording more than %d keys is not supported"), MAX_uint8 + 1);
+			break;
+		}
+
+		FRecordedKey& RecordedKey = Keys.AddDefaulted_GetRef();
+		RecordedKey.Key = Key;
+		RecordedKey.NumComponents = Key.IsAxis3D() ? 3 : Key.IsAxis2D() ? 2 : 1;
+	}
+	return true;
+}
+
+void UGP3ReplaySubsystem::BeginRecord(ERecordKind Kind)
+{
+	WriteVarUInt(Chunk, Frame - LastRecordFrame);
+	Chunk.Add(static_cast<uint8>(Kind));
+	LastRecordFrame = Frame;
+}
+
+void UGP3ReplaySubsystem::RecordFrameTime()
+{
+	const int32 Microseconds = FMath::RoundToInt(FApp::GetDeltaTime() * 1000000.0);
+	BeginRecord(ERecordKind::FrameTime);
+	WriteVarInt(Chunk, Microseconds - LastFrameMicroseconds);
+	LastFrameMicroseconds = Microseconds;
+}
+
+void UGP3ReplaySubsystem::OnInputKey(const FInputKeyParams& Params)
+{
+	if (!IsRecording()) return;
+
+	const int32 Index = Keys.IndexOfByPredicate([&Params](const FRecordedKey& RecordedKey) { return RecordedKey.Key == Params.Key; });
+	if (Index == INDEX_NONE) return;
+
+	// every event on its own, so presses shorter than a frame survive
+	BeginRecord(ERecordKind::Input);
+	Chunk.Add(static_cast<uint8>(Index));
+	Chunk.Add(static_cast<uint8>(Params.Event));
+	if (Params.Event != IE_Axis) return;
+
+	FRecordedKey& RecordedKey = Keys[Index];
+	WriteVarUInt(Chunk, Params.NumSamples);
+	for (int32 Component = 0; Component < RecordedKey.NumComponents; ++Component)
+	{
+		const int32 Quantized = FMath::RoundToInt(Params.Delta[Component] * ValueScale);
+		WriteVarInt(Chunk, Quantized - RecordedKey.Value[Component]);
+		RecordedKey.Value[Component] = Quantized;
+	}
+}
+
+void UGP3ReplaySubsystem::RecordEvent(const AActor* Instigator, const FRecord& Record)
+{
+	if (!Instigator || Instigator != Character) return;
+
+	if (IsReplaying())
+	{
+		CheckReplayedEvent(Record);
+		return;
+	}
+	if (!IsRecording()) return;
+
+	BeginRecord(Record.Kind);
+	switch (Record.Kind)
+	{
+	case ERecordKind::Collectable:
+		Chunk.Add(Record.Type);
+		WriteVarInt(Chunk, Record.Number);
+		break;
+	case ERecordKind::TransferStart:
+		Chunk.Add(Record.Type);
+		break;
+	case ERecordKind::ComboStep:
+		WriteVarUInt(Chunk, Record.Number);
+		break;
+	case ERecordKind::Checkpoint:
+		WriteString(Chunk, Record.Name);
+		WriteVarInt(Chunk, Record.Number);
+		break;
+	default:
+		break;
+	}
+}
+
+bool UGP3ReplaySubsystem::ReadRecord(const uint8*& Cursor, const uint8* End, FRecord& OutRecord) const
+{
+	if (!ReadVarUInt(Cursor, End, OutRecord.FrameDelta) || Cursor >= End) return false;
+
+	OutRecord.Kind = static_cast<ERecordKind>(*Cursor++);
+	switch (OutRecord.Kind)
+	{
+	case ERecordKind::Input:
+	{
+		OutRecord.KeyIndex = Cursor < End ? *Cursor++ : INDEX_NONE;
+		if (!Keys.IsValidIndex(OutRecord.KeyIndex) || Cursor >= End) return false;
+
+		OutRecord.Event = *Cursor++;
+		if (OutRecord.Event != IE_Axis) return true;
+
+		uint32 NumSamples;
+		if (!ReadVarUInt(Cursor, End, NumSamples)) return false;
+		OutRecord.Number = NumSamples;
+		for (int32 Component = 0; Component < Keys[OutRecord.KeyIndex].NumComponents; ++Component)
+		{
+			if (!ReadVarInt(Cursor, End, OutRecord.Values[Component])) return false;
+		}
+		return true;
+	}
+	case ERecordKind::Collectable:
+		if (Cursor >= End) return false;
+		OutRecord.Type = *Cursor++;
+		return ReadVarInt(Cursor, End, OutRecord.Number);
+	case ERecordKind::TransferStart:
+		if (Cursor >= End) return false;
+		OutRecord.Type = *Cursor++;
+		return true;
+	case ERecordKind::ComboStep:
+	{
+		uint32 ComboStep;
+		const bool bIsValid = ReadVarUInt(Cursor, End, ComboStep);
+		OutRecord.Number = ComboStep;
+		return bIsValid;
+	}
+	case ERecordKind::Checkpoint:
+		return ReadString(Cursor, End, OutRecord.Name) && ReadVarInt(Cursor, End, OutRecord.Number);
+	case ERecordKind::FrameTime:
+		return ReadVarInt(Cursor, End, OutRecord.Number);
+	case ERecordKind::TransferStop:
+	case ERecordKind::Dash:
+	case ERecordKind::End:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void UGP3ReplaySubsystem::OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaTime)
+{
+	if (InWorld != GetWorld() || !IsReplaying() || !IsValid(Character)) return;
+
+	ReplayFrame();
+}
+
+void UGP3ReplaySubsystem::ReplayFrame()
+{
+	const uint8* Data = ReplayData.GetData();
+	const uint8* Cursor = Data + ReplayOffset;
+	const uint8* End = Data + ReplayData.Num();
+
+	while (!bHasReachedEnd)
+	{
+		// records due in a later frame are left where they are until then
+		const uint8* RecordStart = Cursor;
+		uint32 FrameDelta;
+		if (!ReadVarUInt(Cursor, End, FrameDelta))
+		{
+			bHasReachedEnd = true;
+			break;
+		}
+		Cursor = RecordStart;
+		if (NextRecordFrame + FrameDelta > Frame) break;
+
+		FRecord Record;
+		if (!ReadRecord(Cursor, End, Record))
+		{
+			GP3_LOG(Warning, TEXT("Recording is truncated or corrupt at byte %d"), static_cast<int32>(RecordStart - Data));
+			bHasReachedEnd = true;
+			break;
+		}
+		NextRecordFrame += Record.FrameDelta;
+
+		switch (Record.Kind)
+		{
+		case ERecordKind::Input:
+			InjectKey(Record);
+			break;
+		case ERecordKind::FrameTime:
+			break;
+		case ERecordKind::End:
+			bHasReachedEnd = true;
+			break;
+		default:
+			// gameplay events wait for the replay to produce them
+			Record.Frame = NextRecordFrame;
+			ExpectedEvents.Add(MoveTemp(Record));
+			break;
+		}
+	}
+	ReplayOffset = Cursor - Data;
+}
+
+void UGP3ReplaySubsystem::InjectKey(const FRecord& Record)
+{
+	FRecordedKey& RecordedKey = Keys[Record.KeyIndex];
+	const EInputEvent Event = static_cast<EInputEvent>(Record.Event);
+	if (Event == IE_Axis)
+	{
+		for (int32 Component = 0; Component < RecordedKey.NumComponents; ++Component)
+		{
+			RecordedKey.Value[Component] += Record.Values[Component];
+		}
+	}
+
+	UGP3PlayerInput* PlayerInput = GetPlayerInput();
+	if (!PlayerInput || !RecordedKey.Key.IsValid()) return;
+
+	const bool bIsGamepad = RecordedKey.Key.IsGamepadKey();
+	if (Event != IE_Axis)
+	{
+		PlayerInput->InjectKey(FInputKeyParams(RecordedKey.Key, Event, Event == IE_Released ? 0.0 : 1.0, bIsGamepad));
+		if (Event == IE_Pressed || Event == IE_Released)
+		{
+			RecordedKey.bIsActive = Event == IE_Pressed;
+		}
+		return;
+	}
+
+	const FVector Value(RecordedKey.Value[0] / ValueScale, RecordedKey.Value[1] / ValueScale, RecordedKey.Value[2] / ValueScale);
+	const float DeltaTime = FApp::GetDeltaTime();
+	if (RecordedKey.NumComponents > 1)
+	{
+		PlayerInput->InjectKey(FInputKeyParams(RecordedKey.Key, Value, DeltaTime, Record.Number, bIsGamepad));
+	}
+	else
+	{
+		PlayerInput->InjectKey(FInputKeyParams(RecordedKey.Key, static_cast<double>(Value.X), DeltaTime, Record.Number, bIsGamepad));
+	}
+}
+
+void UGP3ReplaySubsystem::CheckReplayedEvent(const FRecord& Record)
+{
+	const int32 Index = ExpectedEvents.IndexOfByPredicate([this, &Record](const FRecord& Expected)
+	{
+		return Expected.Frame == Frame && IsSameEvent(Expected, Record);
+	});
+	if (Index != INDEX_NONE)
+	{
+		ExpectedEvents.RemoveAt(Index);
+		++NumMatchedEvents;
+		return;
+	}
+
+	++NumDivergences;
+	const FString Description = DescribeEvent(Record);
+	GP3_LOG(Warning, TEXT("Replay diverged at frame %u: %s was not recorded"), Frame, *Description);
+	TRACE_BOOKMARK(TEXT("GP3 frame %u unexpected %s"), Frame, *Description);
+}
+
+void UGP3ReplaySubsystem::CheckMissingEvents(uint32 UpToFrame)
+{
+	ExpectedEvents.RemoveAll([this, UpToFrame](const FRecord& Expected)
+	{
+		if (Expected.Frame > UpToFrame) return false;
+
+		++NumDivergences;
+		const FString Description = DescribeEvent(Expected);
+		GP3_LOG(Warning, TEXT("Replay diverged at frame %u: recorded %s did not happen"), Expected.Frame, *Description);
+		TRACE_BOOKMARK(TEXT("GP3 frame %u missing %s"), Expected.Frame, *Description);
+		return true;
+	});
+}
+
+void UGP3ReplaySubsystem::FinishReplay()
+{
+	const double Seconds = FPlatformTime::Seconds() - ReplayStartSeconds;
+	GP3_LOG(Log, TEXT("Replay finished: %u frames in %.2f s, %.3f ms per frame"), Frame, Seconds, Frame > 0 ? Seconds * 1000.0 / Frame : 0.0);
+
+	// whatever the replay did not get to counts as missing
+	CheckMissingEvents(MAX_uint32);
+	if (NumDivergences > 0)
+	{
+		GP3_LOG(Warning, TEXT("Replay diverged from the recording: %d of %d gameplay events differ"), NumDivergences, NumMatchedEvents + NumDivergences);
+	}
+	else
+	{
+		GP3_LOG(Log, TEXT("Replay matched all %d recorded gameplay events"), NumMatchedEvents);
+	}
+
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	WorldTickStartHandle.Reset();
+
+	// let go of whatever the recording still held
+	if (UGP3PlayerInput* PlayerInput = IsValid(Character) ? GetPlayerInput() : nullptr)
+	{
+		for (FRecordedKey& RecordedKey : Keys)
+		{
+			if (RecordedKey.bIsActive && RecordedKey.Key.IsValid())
+			{
+				PlayerInput->InjectKey(FInputKeyParams(RecordedKey.Key, IE_Released, 0.0, RecordedKey.Key.IsGamepadKey()));
+			}
+			RecordedKey.bIsActive = false;
+		}
+		PlayerInput->bIsReplaying = false;
+	}
+
+	ReplayData.Empty();
+	ReplayOffset = 0;
+	FrameDeltas.Empty();
+	ExpectedEvents.Empty();
+	FApp::SetBenchmarking(false);
+
+	if (bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, NumDivergences > 0 ? 1 : 0);
+	}
+}
+
+bool UGP3ReplaySubsystem::IsSameEvent(const FRecord& A, const FRecord& B)
+{
+	return A.Kind == B.Kind && A.Type == B.Type && A.Number == B.Number && A.Name == B.Name;
+}
+
+FString UGP3ReplaySubsystem::DescribeEvent(const FRecord& Record)
+{
+	switch (Record.Kind)
+	{
+	case ERecordKind::Collectable:
+		return FString::Printf(TEXT("collectable %d +%d"), Record.Type, Record.Number);
+	case ERecordKind::TransferStart:
+		return FString::Printf(TEXT("transfer start %d"), Record.Type);
+	case ERecordKind::TransferStop:
+		return TEXT("transfer stop");
+	case ERecordKind::Dash:
+		return TEXT("dash");
+	case ERecordKind::ComboStep:
+		return FString::Printf(TEXT("combo step %d"), Record.Number);
+	case ERecordKind::Checkpoint:
+		return FString::Printf(TEXT("checkpoint %s (%d)"), *Record.Name, Record.Number);
+	default:
+		return TEXT("unknown event");
+	}
+}
+
+FString UGP3ReplaySubsystem::GetRecordingPath(const FString& FileName)
+{
+	return FPaths::IsRelative(FileName) ? FPaths::ProjectSavedDir() / TEXT("Recordings") / FileName : FileName;
+}
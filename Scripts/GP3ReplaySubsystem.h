@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Items/ItemTypes.h"
+#include "GP3Recording.h"
+#include "GP3ReplaySubsystem.generated.h"
+
+class APlayerCharacter;
+class UGP3PlayerInput;
+struct FInputKeyParams;
+
+/**
+ * Records the local player's raw key events, frame times and key gameplay events to a
+ * compact binary file, and plays such a file back through Enhanced Input.
+ *
+ * Recording: gp3.Record.Start [File], gp3.Record.Stop
+ * Replay steps every frame with the recorded delta time as fast as the machine allows, e.g.
+ *   -game -nullrhi -unattended -ExecCmds="gp3.Replay Session.gp3rec quit"
+ * Replay checks the gameplay events it produces against the recorded ones frame by frame,
+ * logs every divergence and exits with status 1 if there were any. Files live in Saved/Recordings.
+ * Both need UGP3PlayerInput as the player input class.
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3ReplaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	bool StartRecording(const FString& FileName);
+
+	void StopRecording();
+
+	bool IsRecording() const { return Writer.IsValid(); }
+
+	bool StartReplay(const FString& FileName, bool bQuitWhenDone);
+
+	bool IsReplaying() const { return ReplayData.Num() > 0; }
+
+	// Gameplay events of the recorded character, written while recording and checked while replaying
+	void RecordCollectable(const AActor* Instigator, ECollectableType Type, int32 Value);
+	void RecordTransferStart(const AActor* Instigator, ECollectableType Type);
+	void RecordTransferStop(const AActor* Instigator);
+	void RecordDash(const AActor* Instigator);
+	void RecordComboStep(const AActor* Instigator, int32 ComboStep);
+	void RecordCheckpoint(const AActor* Instigator, FName CheckpointId, int32 CheckpointOrder);
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+private:
+
+	struct FRecordedKey
+	{
+		FKey Key;
+		int32 NumComponents = 0;
+		int32 Value[GP3Recording::MaxValueComponents] = {};
+
+		// pressed, as last injected on replay
+		bool bIsActive = false;
+	};
+
+	// One decoded record, only the fields of its kind are set
+	struct FRecord
+	{
+		uint32 FrameDelta = 0;
+		// absolute frame, only set on replay
+		uint32 Frame = 0;
+		GP3Recording::ERecordKind Kind = GP3Recording::ERecordKind::End;
+		int32 KeyIndex = INDEX_NONE;
+		uint8 Event = 0;
+		int32 Values[GP3Recording::MaxValueComponents] = {};
+		uint8 Type = 0;
+		int32 Number = 0;
+		FString Name;
+	};
+
+	APlayerCharacter* FindLocalCharacter() const;
+
+	UGP3PlayerInput* GetPlayerInput() const;
+
+	// Collects the keys mapped to the character's recorded actions, and the raw axes paired into them
+	bool SetupKeys(APlayerCharacter* Character);
+
+	void BeginRecord(GP3Recording::ERecordKind Kind);
+
+	void RecordFrameTime();
+
+	void OnInputKey(const FInputKeyParams& Params);
+
+	void RecordEvent(const AActor* Instigator, const FRecord& Record);
+
+	// Returns false on a truncated record, input values are deltas left for the caller to apply
+	bool ReadRecord(const uint8*& Cursor, const uint8* End, FRecord& OutRecord) const;
+
+	// Runs before the frame's input is processed, like the hardware events it stands in for
+	void OnWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaTime);
+
+	// Injects the input due this frame and queues its gameplay events for checking
+	void ReplayFrame();
+
+	void InjectKey(const FRecord& Record);
+
+	// Matches an event the replay produced against the ones recorded for this frame
+	void CheckReplayedEvent(const FRecord& Record);
+
+	// Reports recorded events up to UpToFrame the replay did not produce
+	void CheckMissingEvents(uint32 UpToFrame);
+
+	void FinishReplay();
+
+	static bool IsSameEvent(const FRecord& A, const FRecord& B);
+
+	static FString DescribeEvent(const FRecord& Record);
+
+	static FString GetRecordingPath(const FString& FileName);
+
+	UPROPERTY()
+	APlayerCharacter* Character;
+
+	TArray<FRecordedKey> Keys;
+
+	// Recorded delta time of every replay frame, applied as the fixed step of that frame
+	TArray<float> FrameDeltas;
+	int32 LastFrameMicroseconds = 0;
+
+	TUniquePtr<GP3Recording::FWriter> Writer;
+	TArray<uint8> Chunk;
+	FDelegateHandle InputKeyHandle;
+
+	TArray<uint8> ReplayData;
+	int32 ReplayOffset = 0;
+	uint32 NextRecordFrame = 0;
+	FDelegateHandle WorldTickStartHandle;
+	bool bHasReachedEnd = false;
+
+	// Recorded gameplay events read ahead of the replay, until it produces them
+	TArray<FRecord> ExpectedEvents;
+	int32 NumMatchedEvents = 0;
+	int32 NumDivergences = 0;
+
+	uint32 Frame = 0;
+	uint32 LastRecordFrame = 0;
+
+	double ReplayStartSeconds = 0.0;
+	bool bQuitWhenDone = false;
+};
@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3SaveGame.h"
+
+FPlayerProgress::FPlayerProgress()
+{
+	for (int32 Index = 0; Index < FElementPocket::NumElements; ++Index)
+	{
+		TankAmount[Index] = 0;
+	}
+}
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "CharacterTypes.h"
+#include "Characters/ElementPocket.h"
+#include "GP3SaveGame.generated.h"
+
+/**
+ * Player state captured when a checkpoint is activated
+ */
+USTRUCT(BlueprintType)
+struct GP3_TEAM4_API FPlayerProgress
+{
+	GENERATED_BODY()
+
+	UPROPERTY(SaveGame)
+	FElementPocket Pocket;
+
+	// Tank contents per pocket slot, caps and level thresholds stay with the tank component
+	UPROPERTY(SaveGame)
+	int32 TankAmount[FElementPocket::NumElements];
+
+	// False when the player had no tank, TankAmount is left alone on restore
+	UPROPERTY(SaveGame)
+	bool bHasTank = false;
+
+	UPROPERTY(SaveGame)
+	EAbilityLevel StormLevel = EAbilityLevel::EAL_Level0;
+
+	UPROPERTY(SaveGame)
+	EAbilityLevel WindLevel = EAbilityLevel::EAL_Level0;
+
+	UPROPERTY(SaveGame)
+	EAbilityLevel FireLevel = EAbilityLevel::EAL_Level0;
+
+	UPROPERTY(SaveGame)
+	bool bIsOverloaded = false;
+
+	FPlayerProgress();
+};
+
+/**
+ * 
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3SaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(SaveGame)
+	FName CheckpointId;
+
+	UPROPERTY(SaveGame)
+	int32 CheckpointOrder = 0;
+
+	UPROPERTY(SaveGame)
+	FVector CheckpointLocation = FVector::ZeroVector;
+
+	UPROPERTY(SaveGame)
+	FPlayerProgress PlayerProgress;
+};
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GP3SignificanceSubsystem.h"
+#include "SignificanceManager.h"
+#include "GP3Stats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_GP3_SignificanceUpdate, STATGROUP_GP3Gameplay);
+
+void UGP3SignificanceSubsystem::Tick(float DeltaTime)
+{
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_SignificanceUpdate);
+
+	UWorld* World = GetWorld();
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(World);
+	if (!SignificanceManager) return;
+
+	Viewpoints.Reset();
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController = Iterator->Get();
+		if (!PlayerController || !PlayerController->IsLocalController()) continue;
+
+		FVector Location;
+		FRotator Rotation;
+		PlayerController->GetPlayerViewPoint(Location, Rotation);
+		Viewpoints.Emplace(Rotation, Location);
+	}
+
+	SignificanceManager->Update(Viewpoints);
+}
+
+TStatId UGP3SignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGP3SignificanceSubsystem, STATGROUP_Tickables);
+}
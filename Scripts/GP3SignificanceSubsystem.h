@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GP3SignificanceSubsystem.generated.h"
+
+/**
+ * Feeds the significance manager the local players' viewpoints once per frame,
+ * so objects registered with it get their significance re-evaluated.
+ */
+UCLASS()
+class GP3_TEAM4_API UGP3SignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+private:
+
+	TArray<FTransform> Viewpoints;
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Characters/Components/GP3SpringArmComponent.h"
+#include "GP3Stats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Probes Per Frame"), STAT_GP3_CameraProbes, STATGROUP_GP3Gameplay);
+
+UGP3SpringArmComponent::UGP3SpringArmComponent()
+{
+	ProbeDelegate.BindUObject(this, &UGP3SpringArmComponent::OnProbeDone);
+}
+
+void UGP3SpringArmComponent::LateUpdate()
+{
+	// a zero delta keeps the lagged location and rotation where this frame's tick left them
+	UpdateDesiredArmLocation(bDoCollisionTest, bEnableCameraLag, bEnableCameraRotationLag, 0.f);
+}
+
+void UGP3SpringArmComponent::UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime)
+{
+	if (!bAsyncProbe || !bDoTrace)
+	{
+		Super::UpdateDesiredArmLocation(bDoTrace, bDoLocationLag, bDoRotationLag, DeltaTime);
+		return;
+	}
+
+	if (DeltaTime > 0.f)
+	{
+		const float InterpSpeed = ProbeFraction < ArmFraction ? ProbePullInSpeed : ProbeReleaseSpeed;
+		ArmFraction = FMath::FInterpTo(ArmFraction, ProbeFraction, DeltaTime, InterpSpeed);
+	}
+
+	// let the engine place the arm already pulled in, so child transforms are only updated once
+	const float FullArmLength = TargetArmLength;
+	TargetArmLength = FullArmLength * ArmFraction;
+	Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
+	TargetArmLength = FullArmLength;
+	bIsCameraFixed = ArmFraction < 1.f;
+
+	if (DeltaTime <= 0.f) return;
+
+	// probe the full, unobstructed arm
+	const FVector ArmOrigin = PreviousArmOrigin;
+	const FVector DesiredLocation = UnfixedCameraPosition - PreviousDesiredRot.Vector() * FullArmLength * (1.f - ArmFraction);
+
+	const float ReuseDistance = FMath::Max(ProbeReuseDistance, ProbeSize * 0.5f);
+	const bool bHasMoved = !ArmOrigin.Equals(LastProbeOrigin, ReuseDistance) || !DesiredLocation.Equals(LastProbeEnd, ReuseDistance);
+	if (bHasMoved && !bIsProbeInFlight)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GP3SpringArm), false, GetOwner());
+		GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, ArmOrigin, DesiredLocation, FQuat::Identity, ProbeChannel,
+			FCollisionShape::MakeSphere(ProbeSize), QueryParams, FCollisionResponseParams::DefaultResponseParam, &ProbeDelegate);
+
+		bIsProbeInFlight = true;
+		LastProbeOrigin = ArmOrigin;
+		LastProbeEnd = DesiredLocation;
+		INC_DWORD_STAT(STAT_GP3_CameraProbes);
+	}
+}
+
+void UGP3SpringArmComponent::OnProbeDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	bIsProbeInFlight = false;
+
+	ProbeFraction = 1.f;
+	for (const FHitResult& Hit : TraceDatum.OutHits)
+	{
+		if (Hit.bBlockingHit)
+		{
+			ProbeFraction = Hit.Time;
+			break;
+		}
+	}
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "GP3SpringArmComponent.generated.h"
+
+/**
+ * Spring arm that can be re-resolved after its regular tick, so a control rotation
+ * changed late in the frame still reaches the camera before the view is captured.
+ * Its collision probe goes through the async trace API: each frame uses the result
+ * of the previous frame's probe and eases the arm length towards it.
+ */
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class GP3_TEAM4_API UGP3SpringArmComponent : public USpringArmComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UGP3SpringArmComponent();
+
+	// Re-runs the arm against the current control rotation without advancing camera lag
+	void LateUpdate();
+
+	// Falls back to the engine's synchronous probe when off
+	UPROPERTY(EditAnywhere, Category = CameraCollision)
+	bool bAsyncProbe = true;
+
+	// A new probe is only issued once the pivot or the unobstructed camera position moved further than this,
+	// never less than half the probe radius since a smaller move can't change what the sphere touches by much
+	UPROPERTY(EditAnywhere, Category = CameraCollision, meta = (EditCondition = "bAsyncProbe"))
+	float ProbeReuseDistance = 10.f;
+
+	// How fast the arm shortens towards a new hit, kept high so the camera doesn't sit inside walls
+	UPROPERTY(EditAnywhere, Category = CameraCollision, meta = (EditCondition = "bAsyncProbe"))
+	float ProbePullInSpeed = 30.f;
+
+	UPROPERTY(EditAnywhere, Category = CameraCollision, meta = (EditCondition = "bAsyncProbe"))
+	float ProbeReleaseSpeed = 8.f;
+
+protected:
+
+	virtual void UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime) override;
+
+private:
+
+	void OnProbeDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	FTraceDelegate ProbeDelegate;
+
+	bool bIsProbeInFlight = false;
+
+	FVector LastProbeOrigin = FVector(ForceInitToZero);
+	FVector LastProbeEnd = FVector(ForceInitToZero);
+
+	// Fraction of the arm the last probe found free, and the eased fraction actually applied
+	float ProbeFraction = 1.f;
+	float ArmFraction = 1.f;
+};
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// "stat GP3Gameplay" in game, the DWORD counters in the group are reset every frame
+DECLARE_STATS_GROUP(TEXT("GP3 Gameplay"), STATGROUP_GP3Gameplay, STATCAT_Advanced);
+
+// Cycle stats already emit Insights CPU events, Test and Shipping have no stats and keep a plain trace scope
+#if STATS
+#define GP3_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat)
+#else
+#define GP3_SCOPE_CYCLE_COUNTER(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#endif
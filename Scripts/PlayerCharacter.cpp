@@ -3,12 +3,22 @@
 
 #include "Characters/PlayerCharacter.h"
 #include "Characters/Components/TankComponent.h"
+#include "Characters/Components/GP3CharacterMovementComponent.h"
 #include "GameMode/GP3GameModeBase.h"
+#include "GameMode/QuestTankSubsystem.h"
+#include "Items/CollectablePoolSubsystem.h"
+#include "Essence/EssenceSimulationSubsystem.h"
+#include "GP3ReplaySubsystem.h"
+#include "GP3CooldownSubsystem.h"
+#include "GP3Log.h"
+#include "GP3Benchmark.h"
+#include "GP3Stats.h"
+#include "GP3SaveGame.h"
 
 #include "Components/InputComponent.h"
 #include "Components/BoxComponent.h"
 #include "Camera/CameraComponent.h"
-#include "GameFramework/SpringArmComponent.h"
+#include "Characters/Components/GP3SpringArmComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
@@ -17,12 +27,41 @@
 #include "Components/CapsuleComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "SignificanceManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Tick"), STAT_GP3_CharacterTick, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Overloaded Drain"), STAT_GP3_OverloadedDrain, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Attack"), STAT_GP3_Attack, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Dash"), STAT_GP3_Dash, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Start Tank Transfer"), STAT_GP3_StartTankTransfer, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Commit Tank Transfer"), STAT_GP3_CommitTankTransfer, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Quest Tank Transfer"), STAT_GP3_QuestTankTransfer, STATGROUP_GP3Gameplay);
+DECLARE_CYCLE_STAT(TEXT("Melee Sweep"), STAT_GP3_MeleeSweep, STATGROUP_GP3Gameplay);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Look Input To View (ms)"), STAT_GP3_LookLatency, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tank Transfers Per Frame"), STAT_GP3_TankTransfers, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Essence Transferred Per Frame"), STAT_GP3_EssenceTransferred, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Drain Events Per Frame"), STAT_GP3_DrainEvents, STATGROUP_GP3Gameplay);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Quest Tank Lookups Per Frame"), STAT_GP3_QuestTankLookups, STATGROUP_GP3Gameplay);
+
+static const FName CombatCooldownId(TEXT("Combat"));
+static const FName DashCooldownId(TEXT("DashCooldown"));
+static const FName DashTimerId(TEXT("Dash"));
+
+// Units the tank can still take of Type, queried once so a batched add never overshoots
+static int GetTankSpace(const UTankComponent* Tank, ECollectableType Type)
+{
+	return FMath::Max(Tank->GetTypeCapacity(Type) - Tank->GetTypeAmount(Type), 0);
+}
 
 // Sets default values
-APlayerCharacter::APlayerCharacter()
+APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UGP3CharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
- 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+ 	// Nothing needs per-frame work by default, overload drain runs on a timer
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = false;
@@ -33,47 +72,80 @@ APlayerCharacter::APlayerCharacter()
 		Movement->bOrientRotationToMovement = true;
 		Movement->RotationRate = FRotator(0.0f, 360.0f, 0.0f);
 	}
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("Camera Boom"));
+	CameraBoom = CreateDefaultSubobject<UGP3SpringArmComponent>(TEXT("Camera Boom"));
 	CameraBoom->TargetArmLength = 600.0f;
 	CameraBoom->SetupAttachment(RootComponent);
 
 	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("Follow Camera"));
 	FollowCamera->SetupAttachment(CameraBoom);
 
+	// keeps its own collision, Blueprints that deal damage from its overlap events still work
 	AttackCollision = CreateDefaultSubobject<UBoxComponent>(TEXT("Attack Area"));
 	AttackCollision->SetupAttachment(RootComponent);
 
+	MeleeTraceDelegate.BindUObject(this, &APlayerCharacter::OnMeleeTraceDone);
+
+	ComboSections = { NAME_None, FName(TEXT("Attack2")), FName(TEXT("Attack3")) };
+
 }
 
 void APlayerCharacter::StartCombatTimer()
 {
-	GetWorldTimerManager().SetTimer(CombatTimerHandle, this, &APlayerCharacter::OnCombatTimerExpired, CombatExpirationTime, false);
+	if (Cooldowns)
+	{
+		Cooldowns->StartCooldown(this, CombatCooldownId, CombatExpirationTime, FOnCooldownExpired::CreateUObject(this, &APlayerCharacter::OnCombatTimerExpired));
+	}
 
-	bIsInCombat = true;
+	SetStance(ECombatStance::ECS_Combat);
 }
 
 void APlayerCharacter::StopCombatTimer()
 {
-	GetWorldTimerManager().ClearTimer(CombatTimerHandle);
+	if (Cooldowns)
+	{
+		Cooldowns->ClearCooldown(this, CombatCooldownId);
+	}
 	
-	bIsInCombat = false;
+	SetStance(ECombatStance::ECS_Exploration);
 }
 
 void APlayerCharacter::OnCombatTimerExpired()
 {
-	bIsInCombat = false;
-	GetCharacterMovement()->MaxWalkSpeed = DefaultMoveSpeed;
+	SetStance(ECombatStance::ECS_Exploration);
+}
+
+void APlayerCharacter::SetStance(ECombatStance NewStance)
+{
+	if (NewStance == Stance) return;
+	Stance = NewStance;
+
+	const bool bCombat = Stance == ECombatStance::ECS_Combat;
+	bIsInCombat = bCombat;
+
+	// strafe facing the camera in combat, face the movement direction while exploring
+	bUseControllerRotationPitch = false;
+	bUseControllerRotationYaw = bCombat;
+	bUseControllerRotationRoll = bCombat;
+
+	GetCharacterMovement()->MaxWalkSpeed = bCombat ? StrafeMoveSpeed : DefaultMoveSpeed;
+	CameraBoom->TargetArmLength = bCombat ? CombatArmLength : ExplorationArmLength;
 }
 
 void APlayerCharacter::StartDashCooldownTimer()
 {
-	GetWorldTimerManager().SetTimer(DashCooldownTimerHandle, this, &APlayerCharacter::OnDashCooldownTimerExpired, DashCooldown, false);
+	if (Cooldowns)
+	{
+		Cooldowns->StartCooldown(this, DashCooldownId, DashCooldown, FOnCooldownExpired::CreateUObject(this, &APlayerCharacter::OnDashCooldownTimerExpired));
+	}
 	bCanDash = false;
 }
 
 void APlayerCharacter::StopDashCooldownTimer()
 {
-	GetWorldTimerManager().ClearTimer(DashCooldownTimerHandle);
+	if (Cooldowns)
+	{
+		Cooldowns->ClearCooldown(this, DashCooldownId);
+	}
 	
 	bCanDash = true;
 }
@@ -85,15 +157,20 @@ void APlayerCharacter::OnDashCooldownTimerExpired()
 
 void APlayerCharacter::StartDashTimer()
 {
-	GetWorldTimerManager().SetTimer(DashTimerHandle, this, &APlayerCharacter::OnDashTimerExpired, DashDuration, false);
-	GetCharacterMovement()->GroundFriction = 0.f;
+	if (Cooldowns)
+	{
+		Cooldowns->StartCooldown(this, DashTimerId, DashDuration, FOnCooldownExpired::CreateUObject(this, &APlayerCharacter::OnDashTimerExpired));
+	}
 	bIsDashing = true;
 	bCanMove = false;
 }
 
 void APlayerCharacter::StopDashTimer()
 {
-	GetWorldTimerManager().ClearTimer(DashTimerHandle);
+	if (Cooldowns)
+	{
+		Cooldowns->ClearCooldown(this, DashTimerId);
+	}
 }
 
 void APlayerCharacter::OnDashTimerExpired()
@@ -103,41 +180,228 @@ void APlayerCharacter::OnDashTimerExpired()
 
 void APlayerCharacter::ResetDash()
 {
-	GetCharacterMovement()->GroundFriction = 8.f;
-	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_GameTraceChannel2, ECollisionResponse::ECR_Block);
+	if (UGP3CharacterMovementComponent* Movement = Cast<UGP3CharacterMovementComponent>(GetCharacterMovement()))
+	{
+		Movement->StopDash();
+	}
 	bIsDashing = false;
 	bCanMove = true;
-	StopDashCooldownTimer();
 	StartDashCooldownTimer();
 }
 
-// Called when the game starts or when spawned
-void APlayerCharacter::BeginPlay()
+void APlayerCharacter::CaptureProgress(FPlayerProgress& OutProgress) const
 {
-	Super::BeginPlay();
-	
-	if (APlayerController* PlayerController = Cast<APlayerController>(GetController()))
+	OutProgress.Pocket = Pocket;
+	OutProgress.StormLevel = CurrentStormLevel;
+	OutProgress.WindLevel = CurrentWindLevel;
+	OutProgress.FireLevel = CurrentFireLevel;
+	OutProgress.bIsOverloaded = bIsOverloaded;
+
+	if (EssenceEntity != INDEX_NONE)
 	{
-		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+		OutProgress.bHasTank = true;
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
 		{
-			Subsystem->ClearAllMappings();
+			OutProgress.TankAmount[Element] = EssenceSimulation->GetSimulation().GetTank(EssenceEntity, Element);
+		}
+		return;
+	}
 
-			Subsystem->AddMappingContext(GroundMappingContext, 0);
+	OutProgress.bHasTank = TankComponent != nullptr;
+	for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+	{
+		OutProgress.TankAmount[Element] = TankComponent ? TankComponent->GetTypeAmount(FElementPocket::Elements[Element]) : 0;
+	}
+}
+
+void APlayerCharacter::RestoreProgress(const FPlayerProgress& Progress)
+{
+	// caps stay data-driven, only the carried amounts come from the save
+	FMemory::Memcpy(Pocket.Count, Progress.Pocket.Count, sizeof(Pocket.Count));
+
+	// the simulation owns the tank, levels and overload follow from the restored amounts
+	if (EssenceEntity != INDEX_NONE)
+	{
+		FEssenceSimulation& Simulation = EssenceSimulation->GetSimulation();
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+		{
+			Simulation.SetPocket(EssenceEntity, Element, Pocket.Count[Element]);
+			if (Progress.bHasTank)
+			{
+				Simulation.SetTank(EssenceEntity, Element, Progress.TankAmount[Element]);
+			}
 		}
+		ApplyEssenceState(Simulation, EssenceEntity, Simulation.ConsumeDirtyFlags(EssenceEntity));
+		return;
+	}
+
+	CurrentStormLevel = Progress.StormLevel;
+	CurrentWindLevel = Progress.WindLevel;
+	CurrentFireLevel = Progress.FireLevel;
+	bIsOverloaded = Progress.bIsOverloaded;
+	NotifyPocketChanged();
+	for (const ECollectableType Type : FElementPocket::Elements)
+	{
+		MarkAbilityLevelNetDirty(Type);
+		OnAbilityLevelChanged.Broadcast(Type, *FindAbilityLevel(Type));
 	}
 
+	// through the tank's own setter, so its change handling runs the same on respawn and on load
+	if (TankComponent && Progress.bHasTank)
+	{
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+		{
+			TankComponent->SetTypeAmount(FElementPocket::Elements[Element], Progress.TankAmount[Element]);
+		}
+		BroadcastTankChanges();
+	}
+
+	UpdateOverloadDrain();
+}
+
+void APlayerCharacter::RespawnInPlace(const FVector& Location, const FPlayerProgress& Progress)
+{
+	GP3_BENCHMARK_SCOPE("RespawnInPlace");
+
+	// drop anything in flight without committing it
+	bIsTransferring = false;
+	PendingTransfer = 0.0f;
+	CloseHitWindow();
+	UpdateTickEnabled();
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+	ActionState = EActionState::EAS_Unoccupied;
+	ComboCount = 0;
+	BufferedAttackTime = -1.0;
+
+	if (Cooldowns)
+	{
+		Cooldowns->ClearCooldowns(this);
+	}
+	if (UGP3CharacterMovementComponent* Movement = Cast<UGP3CharacterMovementComponent>(GetCharacterMovement()))
+	{
+		Movement->StopDash();
+		Movement->StopMovementImmediately();
+	}
+	bIsDashing = false;
+	bCanDash = true;
+	bCanMove = true;
+	SetStance(ECombatStance::ECS_Exploration);
+
+	RestoreProgress(Progress);
+
+	SetActorLocation(Location, false, nullptr, ETeleportType::ResetPhysics);
+}
+
+// Called when the game starts or when spawned
+void APlayerCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+	
+	AddGroundMappingContext();
+
+	ExplorationArmLength = CameraBoom->TargetArmLength;
+
 	TankComponent = FindComponentByClass<UTankComponent>();
 	GameMode = Cast<AGP3GameModeBase>(UGameplayStatics::GetGameMode(GetWorld()));
+	QuestTankSubsystem = GetWorld()->GetSubsystem<UQuestTankSubsystem>();
+	Cooldowns = GetWorld()->GetSubsystem<UGP3CooldownSubsystem>();
+	Replay = GetWorld()->GetSubsystem<UGP3ReplaySubsystem>();
+
+	if (UCollectablePoolSubsystem* CollectablePool = GetWorld()->GetSubsystem<UCollectablePoolSubsystem>())
+	{
+		CollectablePool->RegisterCollector(this);
+	}
+
+	RegisterSignificance();
+
+	// only the server simulates, clients keep predicting through the components
+	if (bSimulateEssence && HasAuthority() && TankComponent)
+	{
+		EssenceSimulation = GetWorld()->GetSubsystem<UEssenceSimulationSubsystem>();
+		const FEssenceSimulation::FRules Rules = UEssenceSimulationSubsystem::MakeRules(*TankComponent, TankDrainRate, DrainTimer, TankTransferRate);
+		EssenceEntity = EssenceSimulation->RegisterCharacter(this, Rules);
+	}
+
+	LateLookHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &APlayerCharacter::ApplyLateLook);
 	
 }
 
+void APlayerCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// the socket is per Blueprint, so the box can only move onto it once defaults are applied
+	if (!AttackSocketName.IsNone())
+	{
+		AttackCollision->AttachToComponent(GetMesh(), FAttachmentTransformRules::KeepRelativeTransform, AttackSocketName);
+	}
+}
+
+void APlayerCharacter::PawnClientRestart()
+{
+	Super::PawnClientRestart();
+
+	AddGroundMappingContext();
+}
+
+void APlayerCharacter::AddGroundMappingContext()
+{
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (!PlayerController) return;
+
+	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer()))
+	{
+		Subsystem->ClearAllMappings();
+
+		Subsystem->AddMappingContext(GroundMappingContext, 0);
+	}
+}
+
+void APlayerCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Cooldowns)
+	{
+		Cooldowns->ClearCooldowns(this);
+	}
+
+	if (UCollectablePoolSubsystem* CollectablePool = GetWorld()->GetSubsystem<UCollectablePoolSubsystem>())
+	{
+		CollectablePool->UnregisterCollector(this);
+	}
+
+	UnregisterSignificance();
+
+	if (EssenceEntity != INDEX_NONE)
+	{
+		EssenceSimulation->UnregisterCharacter(EssenceEntity);
+		EssenceEntity = INDEX_NONE;
+	}
+
+	FWorldDelegates::OnWorldPostActorTick.Remove(LateLookHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void APlayerCharacter::Tick(float DeltaTime)
 {
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_CharacterTick);
+
 	Super::Tick(DeltaTime);
-	if (bIsOverloaded)
+
+	if (bIsTransferring)
+	{
+		PendingTransfer += TankTransferRate * DeltaTime;
+		CommitTankTransfer();
+	}
+
+	if (bIsHitWindowOpen)
 	{
-		OverloadedDrain();
+		TraceMeleeSwing();
 	}
 }
 
@@ -160,9 +424,12 @@ void APlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCom
 		
 		EnhancedInputComponent->BindAction(AttackAction, ETriggerEvent::Triggered, this, &APlayerCharacter::Attack);
 		
-		EnhancedInputComponent->BindAction(FireTransferAction, ETriggerEvent::Triggered, this, &APlayerCharacter::FireTankTranfer);
-		EnhancedInputComponent->BindAction(WindTransferAction, ETriggerEvent::Triggered, this, &APlayerCharacter::WindTankTranfer);
-		EnhancedInputComponent->BindAction(StormTransferAction, ETriggerEvent::Triggered, this, &APlayerCharacter::EarthTankTranfer);
+		EnhancedInputComponent->BindAction(FireTransferAction, ETriggerEvent::Started, this, &APlayerCharacter::FireTankTranfer);
+		EnhancedInputComponent->BindAction(WindTransferAction, ETriggerEvent::Started, this, &APlayerCharacter::WindTankTranfer);
+		EnhancedInputComponent->BindAction(StormTransferAction, ETriggerEvent::Started, this, &APlayerCharacter::EarthTankTranfer);
+		EnhancedInputComponent->BindAction(FireTransferAction, ETriggerEvent::Completed, this, &APlayerCharacter::StopTankTransfer);
+		EnhancedInputComponent->BindAction(WindTransferAction, ETriggerEvent::Completed, this, &APlayerCharacter::StopTankTransfer);
+		EnhancedInputComponent->BindAction(StormTransferAction, ETriggerEvent::Completed, this, &APlayerCharacter::StopTankTransfer);
 		EnhancedInputComponent->BindAction(TankDrainAction, ETriggerEvent::Triggered, this, &APlayerCharacter::TankDrainPressed);
 		EnhancedInputComponent->BindAction(QuestInteractAction, ETriggerEvent::Triggered, this, &APlayerCharacter::QuestTankTransfer);
 	}
@@ -171,37 +438,21 @@ void APlayerCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCom
 
 void APlayerCharacter::Move(const FInputActionValue& Value)
 {
+	GP3_BENCHMARK_SCOPE("Move");
+
 	MoveAxisVector = Value.Get<FVector2D>();
 
-	if (!bCanMove) return;
+	if (!bCanMove || !GetController()) return;
 
-	if (GetController())
+	// Blueprints can still flip bIsInCombat directly
+	if (bIsInCombat != (Stance == ECombatStance::ECS_Combat))
 	{
-		const FRotator ControlRotation = GetControlRotation();
-		const FRotator YawRotation(0.0f, ControlRotation.Yaw, 0.0f);
-
-		const FVector ForwardDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
-		const FVector RightDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
-
-		if (bIsInCombat)
-		{
-			bUseControllerRotationPitch = false;
-			bUseControllerRotationYaw = true;
-			bUseControllerRotationRoll = true;
-
-			AddMovementInput(ForwardDirection, MoveAxisVector.Y);
-			AddMovementInput(RightDirection, MoveAxisVector.X);
-		}
-		else
-		{
-			bUseControllerRotationPitch = false;
-			bUseControllerRotationYaw = false;
-			bUseControllerRotationRoll = false;
-
-			AddMovementInput(ForwardDirection, MoveAxisVector.Y);
-			AddMovementInput(RightDirection, MoveAxisVector.X);
-		}
+		SetStance(bIsInCombat ? ECombatStance::ECS_Combat : ECombatStance::ECS_Exploration);
 	}
+
+	const FRotationMatrix YawBasis(FRotator(0.0f, GetControlRotation().Yaw, 0.0f));
+	AddMovementInput(YawBasis.GetUnitAxis(EAxis::X), MoveAxisVector.Y);
+	AddMovementInput(YawBasis.GetUnitAxis(EAxis::Y), MoveAxisVector.X);
 }
 
 void APlayerCharacter::ResetMovementVector()
@@ -211,6 +462,9 @@ void APlayerCharacter::ResetMovementVector()
 
 void APlayerCharacter::Dash()
 {
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_Dash);
+	GP3_BENCHMARK_SCOPE("Dash");
+
 	FVector DashDirection;
 
 	// if tne player is not in combat and inputting a direction, we make them dash towards their forward vctor
@@ -237,177 +491,256 @@ void APlayerCharacter::Dash()
 		DashDirection.Normalize();
 	}
 	
-	FVector DashVelocity = DashDirection * DashDistance;
-
 	if (bCanDash)
 	{
+		if (Replay)
+		{
+			Replay->RecordDash(this);
+		}
+
 		// start the dash timer so the dashing state is reset when it finishes
-		StopDashTimer();
 		StartDashTimer();
-		
-		GetCharacterMovement()->GroundFriction = 0.f;
-		bIsDashing = true;
-		bCanMove = false;
-		
-		GetCharacterMovement()->AddImpulse(DashVelocity, true);
 
-		// ignore enemies while dashing
-		GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_GameTraceChannel2, ECollisionResponse::ECR_Ignore);
+		// the dash movement mode passes through enemies without touching the capsule's collision profile
+		if (UGP3CharacterMovementComponent* Movement = Cast<UGP3CharacterMovementComponent>(GetCharacterMovement()))
+		{
+			Movement->StartDash(DashDirection, DashDistance, DashDuration);
+		}
 
 		// start the dash cooldown timer so the player can dash again when it finishes
-		StopDashCooldownTimer();
 		StartDashCooldownTimer();
 	}
 }
 
 void APlayerCharacter::Look(const FInputActionValue& Value)
 {
-	FVector2D LookAxisVector = Value.Get<FVector2D>();
+	GP3_BENCHMARK_SCOPE("Look");
+
+	// high polling rate mice can trigger several times a frame, the latency counts from the first
+	if (PendingLook.IsZero())
+	{
+		PendingLookCycles = FPlatformTime::Cycles64();
+	}
+	PendingLook += Value.Get<FVector2D>();
+}
+
+void APlayerCharacter::ApplyLateLook(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld() || PendingLook.IsZero()) return;
+
+	const FVector2D LookAxisVector = PendingLook;
+	PendingLook = FVector2D::ZeroVector;
 
-	if (GetController())
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (!PlayerController || !PlayerController->IsLocalController()) return;
+
+	// the controller already ran UpdateRotation this frame, apply the late input on top of it
+	PlayerController->AddYawInput(LookAxisVector.X);
+	PlayerController->AddPitchInput(LookAxisVector.Y);
+	PlayerController->UpdateRotation(DeltaSeconds);
+	PlayerController->RotationInput = FRotator::ZeroRotator;
+
+	CameraBoom->LateUpdate();
+
+	const uint64 LatencyCycles = FPlatformTime::Cycles64() - PendingLookCycles;
+	SET_FLOAT_STAT(STAT_GP3_LookLatency, FPlatformTime::ToMilliseconds64(LatencyCycles));
+#if GP3_BENCHMARK_TIMING
+	if (GP3Benchmark::bIsRecording)
 	{
-		AddControllerYawInput(LookAxisVector.X);
-		AddControllerPitchInput(LookAxisVector.Y);
+		GP3Benchmark::Record(TEXT("LookInputToView"), LatencyCycles);
 	}
+#endif
 }
 
 void APlayerCharacter::Attack(const FInputActionValue& Value)
 {
-	if (!bIsInCombat) bIsInCombat = true;
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_Attack);
+	GP3_BENCHMARK_SCOPE("Attack");
 
-	GetCharacterMovement()->MaxWalkSpeed = StrafeMoveSpeed;
+	if (TryAttack())
+	{
+		BufferedAttackTime = -1.0;
+	}
+	else
+	{
+		// too early for the next combo step, keep the press until CanAttack opens the window
+		BufferedAttackTime = GetWorld()->GetTimeSeconds();
+	}
+}
+
+bool APlayerCharacter::TryAttack()
+{
+	if (ActionState != EActionState::EAS_Unoccupied && ActionState != EActionState::EAS_CanAttack) return false;
+
+	// a buffered press replays after AttackEnd has already dropped back to exploration
+	SetStance(ECombatStance::ECS_Combat);
 
 	// make player face camera forward when attack starts
 	FVector CameraForwardVector = FollowCamera->GetForwardVector();
 
 	FRotator TargetRotation = FRotator(0.f, CameraForwardVector.Rotation().Yaw, 0.f);
 	SetActorRotation(TargetRotation);
-	
-	if (ActionState == EActionState::EAS_Unoccupied || ActionState == EActionState::EAS_CanAttack)
-	{
-		AttackSequence();
-		if (TankComponent)
-		{
-			TankComponent->DrainEssence(TankDrainRate, bIsOverloaded);
-			SetAbilityLevel(ECollectableType::ECT_Earth);
-			SetAbilityLevel(ECollectableType::ECT_Wind);
-			SetAbilityLevel(ECollectableType::ECT_Fire);
-		}
-		ActionState = EActionState::EAS_Attacking;
-	}
-}
 
-//NAME CHANGED IT"S STORM ELEMENT NOW
-void APlayerCharacter::EarthTankTranfer(const FInputActionValue& Value)
-{
-	if (!TankComponent) return;
-	bool bTankFull = false;
-	if (EarthCollectCount == 0) return;
-	TankComponent->AddEssence(ECollectableType::ECT_Earth, TankFlowRate, bTankFull);
-	SetAbilityLevel(ECollectableType::ECT_Earth);
-	if (CurrentStormLevel == EAbilityLevel::EAL_Level1)
+	AttackSequence();
+	if (Replay)
 	{
-	UE_LOG(LogTemp, Warning, TEXT("CURRENT Storm LEVEL IS: levl1"));
+		Replay->RecordComboStep(this, ComboCount);
 	}
-	if (CurrentStormLevel == EAbilityLevel::EAL_Level2)
+	if (EssenceEntity != INDEX_NONE)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT Storm LEVEL IS: levl2"));
+		EssenceSimulation->GetSimulation().Drain(EssenceEntity, TankDrainRate);
 	}
-	if (CurrentStormLevel == EAbilityLevel::EAL_Level3)
+	else if (TankComponent)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT Storm LEVEL IS: levl3"));
+		TankComponent->DrainEssence(TankDrainRate, bIsOverloaded);
+		UpdateOverloadDrain();
+		MarkAbilityLevelsDirty();
 	}
-	if (!bTankFull)
+	ActionState = EActionState::EAS_Attacking;
+	return true;
+}
+
+void APlayerCharacter::ConsumeBufferedAttack()
+{
+	if (BufferedAttackTime < 0.0) return;
+
+	const bool bIsBufferValid = GetWorld()->GetTimeSeconds() - BufferedAttackTime <= AttackBufferTime;
+	BufferedAttackTime = -1.0;
+
+	if (bIsBufferValid)
 	{
-		EarthCollectCount -= TankFlowRate;
+		TryAttack();
 	}
 }
 
+//NAME CHANGED IT"S STORM ELEMENT NOW
+void APlayerCharacter::EarthTankTranfer(const FInputActionValue& Value)
+{
+	GP3_BENCHMARK_SCOPE("EarthTankTranfer");
+
+	RequestTankTransfer(ECollectableType::ECT_Earth);
+}
+
 void APlayerCharacter::WindTankTranfer(const FInputActionValue& Value)
 {
-	if (!TankComponent) return;
-	bool bTankFull = false;
-	if (WindCollectCount == 0) return;
-	TankComponent->AddEssence(ECollectableType::ECT_Wind, TankFlowRate, bTankFull);
-	SetAbilityLevel(ECollectableType::ECT_Wind);
-	if (CurrentWindLevel == EAbilityLevel::EAL_Level1)
+	GP3_BENCHMARK_SCOPE("WindTankTranfer");
+
+	RequestTankTransfer(ECollectableType::ECT_Wind);
+}
+
+void APlayerCharacter::FireTankTranfer(const FInputActionValue& Value)
+{
+	GP3_BENCHMARK_SCOPE("FireTankTranfer");
+
+	RequestTankTransfer(ECollectableType::ECT_Fire);
+}
+
+void APlayerCharacter::StopTankTransfer(const FInputActionValue& Value)
+{
+	const bool bWasTransferring = EssenceEntity != INDEX_NONE ? EssenceSimulation->GetSimulation().IsTransferring(EssenceEntity) : bIsTransferring;
+	if (Replay && bWasTransferring)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT Wind LEVEL IS: levl1"));
+		Replay->RecordTransferStop(this);
 	}
-	if (CurrentWindLevel == EAbilityLevel::EAL_Level2)
+
+	EndTankTransfer();
+	if (!HasAuthority())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT Wind LEVEL IS: levl2"));
+		ServerEndTankTransfer();
 	}
-	if (CurrentWindLevel == EAbilityLevel::EAL_Level3)
+}
+
+
+void APlayerCharacter::TankDrainPressed(const FInputActionValue& Value)
+{
+	if (EssenceEntity != INDEX_NONE)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT Wind LEVEL IS: levl3"));
+		EssenceSimulation->GetSimulation().Drain(EssenceEntity, 1);
+		return;
 	}
-	if (!bTankFull)
-	{
 
-		WindCollectCount -= TankFlowRate;
-	}
+	TankComponent->DrainTank(1);
+	MarkAbilityLevelsDirty();
 }
 
-void APlayerCharacter::FireTankTranfer(const FInputActionValue& Value)
+void APlayerCharacter::QuestTankTransfer(const FInputActionValue& Value)
 {
-	if (!TankComponent) return;
-	bool bTankFull = false;
-	if (FireCollectCount == 0) return;
-	TankComponent->AddEssence(ECollectableType::ECT_Fire, TankFlowRate, bTankFull);
-	SetAbilityLevel(ECollectableType::ECT_Fire);
-	if (CurrentFireLevel == EAbilityLevel::EAL_Level1)
+	if (HasAuthority())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT FIRE LEVEL IS: levl1"));
+		TransferToQuestTank();
+		return;
 	}
-	if (CurrentFireLevel == EAbilityLevel::EAL_Level2)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT FIRE LEVEL IS: levl2"));
-	}
-	if (CurrentFireLevel == EAbilityLevel::EAL_Level3)
+
+	// clients only predict the pocket, the server decides what the quest tank takes
+	if (UTankComponent* QuestTankComponent = FindQuestTank())
 	{
-		UE_LOG(LogTemp, Warning, TEXT("CURRENT FIRE LEVEL IS: levl3"));
+		const ECollectableType AskedType = QuestTankComponent->GetAskedType();
+		if (GetPocketAmount(AskedType) > 0)
+		{
+			HandleQuestTank(AskedType, TankFlowRate);
+		}
 	}
-	if (!bTankFull)
+	ServerQuestTankTransfer();
+}
+
+void APlayerCharacter::ServerQuestTankTransfer_Implementation()
+{
+	if (!TransferToQuestTank())
 	{
-		FireCollectCount -= TankFlowRate;
+		ClientSyncPocket(Pocket);
 	}
 }
 
-
-void APlayerCharacter::TankDrainPressed(const FInputActionValue& Value)
+bool APlayerCharacter::TransferToQuestTank()
 {
-	TankComponent->DrainTank(1);
-	SetAbilityLevel(ECollectableType::ECT_Earth);
-	SetAbilityLevel(ECollectableType::ECT_Wind);
-	SetAbilityLevel(ECollectableType::ECT_Fire);
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_QuestTankTransfer);
+	GP3_BENCHMARK_SCOPE("QuestTankTransfer");
+
+	UTankComponent* QuestTankComponent = FindQuestTank();
+	if (!QuestTankComponent) return false;
+
+	const ECollectableType AskedType = QuestTankComponent->GetAskedType();
+	const int Space = GetTankSpace(QuestTankComponent, AskedType);
+
+	// the pocket only gives what the quest tank has room for, the quest tank then gets exactly that
+	int Accepted;
+	if (EssenceEntity != INDEX_NONE)
+	{
+		Accepted = EssenceSimulation->GetSimulation().FillQuestTank(EssenceEntity, FElementPocket::ToIndex(AskedType), TankFlowRate, Space);
+	}
+	else
+	{
+		Accepted = FMath::Min3(TankFlowRate, GetPocketAmount(AskedType), Space);
+		HandleQuestTank(AskedType, Accepted);
+	}
+	if (Accepted <= 0) return false;
+
+	bool bIsTankFull = false;
+	QuestTankComponent->AddSelectedType(AskedType, Accepted, bIsTankFull);
+	return true;
 }
 
-void APlayerCharacter::QuestTankTransfer(const FInputActionValue& Value)
+UTankComponent* APlayerCharacter::FindQuestTank()
 {
+	INC_DWORD_STAT(STAT_GP3_QuestTankLookups);
+
 	float Distance;
-	bool bIsTankFull = false;
+	if (QuestTankSubsystem && QuestTankSubsystem->HasQuestTanks())
+	{
+		return QuestTankSubsystem->FindClosestQuestTank(GetActorLocation(), MaximumInteractionRange, Distance);
+	}
+	if (!GameMode) return nullptr;
+
+	// levels whose quest tanks don't register with the subsystem still go through the game mode scan
 	AActor* QuestTank = GameMode->GetClosestActor(Distance);
+	if (!QuestTank || Distance >= MaximumInteractionRange) return nullptr;
 
-	if (QuestTank && Distance < MaximumInteractionRange)
+	UTankComponent* QuestTankComponent = QuestTank->FindComponentByClass<UTankComponent>();
+	if (!QuestTankComponent)
 	{
-		ECollectableType AskedType;
-		UTankComponent* QuestTankComponent = QuestTank->FindComponentByClass<UTankComponent>();
-		if (QuestTankComponent)
-		{
-			AskedType = QuestTankComponent->GetAskedType();
-			if (GetPocketAmount(AskedType) > 0)
-			{
-				QuestTankComponent->AddSelectedType(AskedType, TankFlowRate, bIsTankFull);
-				HandleQuestTank(AskedType, TankFlowRate , bIsTankFull);
-			}
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Quest tank has no tank Component"));
-		}
-		
+		GP3_LOG_THROTTLED(QuestTank, 5.f, Warning, TEXT("Quest tank %s has no tank Component"), *QuestTank->GetName());
 	}
+	return QuestTankComponent;
 }
 
 #pragma endregion
@@ -415,46 +748,45 @@ void APlayerCharacter::QuestTankTransfer(const FInputActionValue& Value)
 
 void APlayerCharacter::GotCollectable(ECollectableType CollectableType, int CollectValue, bool& bIsCollectSuccess)
 {
+	GP3_BENCHMARK_SCOPE("GotCollectable");
 
-	switch (CollectableType)
+	if (Replay)
 	{
-	case ECollectableType::ECT_Earth:
-		if (EarthCollectCount < EarthMaxAmmount)
-		{
-			EarthCollectCount += CollectValue;
-			if (EarthCollectCount >= EarthMaxAmmount)
-			{
-				EarthCollectCount = EarthMaxAmmount;
-			}
-			bIsCollectSuccess = true;
-		}
-		break;
-	case ECollectableType::ECT_Wind:
-		if (WindCollectCount < WindMaxAmmount)
-		{
-			WindCollectCount += CollectValue;
-			if (WindCollectCount >= WindMaxAmmount)
-			{
-				WindCollectCount = WindMaxAmmount;
-			}
-			bIsCollectSuccess = true;
-		}
-		break;
-	case ECollectableType::ECT_Fire:
-		if (FireCollectCount < FireMaxAmmount)
+		Replay->RecordCollectable(this, CollectableType, CollectValue);
+	}
+
+	if (EssenceEntity != INDEX_NONE)
+	{
+		bIsCollectSuccess = EssenceSimulation->GetSimulation().Collect(EssenceEntity, FElementPocket::ToIndex(CollectableType), CollectValue);
+		return;
+	}
+
+	bIsCollectSuccess = Pocket.Add(CollectableType, CollectValue);
+	if (bIsCollectSuccess)
+	{
+		NotifyPocketChanged();
+	}
+}
+
+void APlayerCharacter::GotCollectables(const int32 (&Values)[FElementPocket::NumElements])
+{
+	GP3_BENCHMARK_SCOPE("GotCollectables");
+
+	if (EssenceEntity != INDEX_NONE)
+	{
+		FEssenceSimulation& Simulation = EssenceSimulation->GetSimulation();
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
 		{
-			FireCollectCount += CollectValue;
-			if (FireCollectCount >= FireMaxAmmount)
+			if (Values[Element] > 0)
 			{
-				FireCollectCount = FireMaxAmmount;
+				Simulation.Collect(EssenceEntity, Element, Values[Element]);
 			}
-			bIsCollectSuccess = true;
 		}
-		break;
-	default:
-		bIsCollectSuccess = false;
-		break;
+		return;
 	}
+
+	Pocket.AddAll(Values);
+	NotifyPocketChanged();
 }
 
 void APlayerCharacter::AttackSequence()
@@ -462,32 +794,85 @@ void APlayerCharacter::AttackSequence()
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 	if (AnimInstance && AttackMontage)
 	{
-		switch (ComboCount)
+		if (!ComboSections.IsValidIndex(ComboCount)) return;
+
+		const FName Section = ComboSections[ComboCount];
+		if (Section.IsNone())
+		{
+			AnimInstance->Montage_Play(AttackMontage);
+		}
+		else
 		{
-			case 0:
-				AnimInstance->Montage_Play(AttackMontage);
-				break;
-			case 1:
-				AnimInstance->Montage_JumpToSection("Attack2");
-				break;
-			case 2:
-				AnimInstance->Montage_JumpToSection("Attack3");
-				break;
-			default:
-				break;
+			AnimInstance->Montage_JumpToSection(Section, AttackMontage);
 		}
 	}
 }
 
 void APlayerCharacter::CanAttack()
 {
+	CloseHitWindow();
 	ComboCount++;
 	ActionState = EActionState::EAS_CanAttack;
+	ConsumeBufferedAttack();
 }
 
 void APlayerCharacter::Hitting()
 {
 	ActionState = EActionState::EAS_HitEnemies;
+	OpenHitWindow();
+}
+
+void APlayerCharacter::OpenHitWindow()
+{
+	if (bIsHitWindowOpen) return;
+
+	bIsHitWindowOpen = true;
+	++SwingId;
+	HitActorsThisSwing.Reset();
+	LastSwingLocation = AttackCollision->GetComponentLocation();
+
+	// catch anything already inside the box on the first frame
+	TraceMeleeSwing();
+	UpdateTickEnabled();
+}
+
+void APlayerCharacter::CloseHitWindow()
+{
+	if (!bIsHitWindowOpen) return;
+
+	bIsHitWindowOpen = false;
+	UpdateTickEnabled();
+}
+
+void APlayerCharacter::TraceMeleeSwing()
+{
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_MeleeSweep);
+	GP3_BENCHMARK_SCOPE("MeleeSweep");
+
+	const FVector SwingLocation = AttackCollision->GetComponentLocation();
+	const FCollisionShape Shape = FCollisionShape::MakeBox(AttackCollision->GetScaledBoxExtent());
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(GP3MeleeSweep), false, this);
+	GetWorld()->AsyncSweepByObjectType(EAsyncTraceType::Multi, LastSwingLocation, SwingLocation, AttackCollision->GetComponentQuat(),
+		FCollisionObjectQueryParams(MeleeHitObjectChannel), Shape, QueryParams, &MeleeTraceDelegate, SwingId);
+
+	LastSwingLocation = SwingLocation;
+}
+
+void APlayerCharacter::OnMeleeTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	// results arrive a frame later, the last segment still counts after the window closes
+	// but anything from an earlier swing is dropped
+	if (TraceDatum.UserData != SwingId) return;
+
+	for (const FHitResult& Hit : TraceDatum.OutHits)
+	{
+		AActor* HitActor = Hit.GetActor();
+		if (!HitActor || HitActorsThisSwing.Contains(HitActor)) continue;
+
+		HitActorsThisSwing.Add(HitActor);
+		OnMeleeHit.Broadcast(HitActor, Hit);
+	}
 }
 
 void APlayerCharacter::Dashing()
@@ -502,79 +887,490 @@ void APlayerCharacter::HeavyAttack()
 
 void APlayerCharacter::AttackEnd()
 {
+	CloseHitWindow();
 	OnCombatTimerExpired();
 	ActionState = EActionState::EAS_Unoccupied;
 	ComboCount = 0;
+	ConsumeBufferedAttack();
 }
 
 void APlayerCharacter::SetAbilityLevel(ECollectableType Type)
 {
 	if (!TankComponent) return;
+	EAbilityLevel* Level = FindAbilityLevel(Type);
+	if (!Level) return;
+
+	const EAbilityLevel NewLevel = TankComponent->CheckTypeLevel(Type);
+	if (NewLevel == *Level) return;
+
+	*Level = NewLevel;
+	MarkAbilityLevelNetDirty(Type);
+	GP3_LOG(Log, TEXT("CURRENT %s LEVEL IS: levl%d"), *UEnum::GetDisplayValueAsText(Type).ToString(), static_cast<int32>(NewLevel));
+	OnAbilityLevelChanged.Broadcast(Type, NewLevel);
+}
+
+void APlayerCharacter::MarkAbilityLevelsDirty()
+{
+	if (bAbilityLevelsDirty) return;
+
+	// several tank changes in one frame only cost one level check per element
+	bAbilityLevelsDirty = true;
+	GetWorldTimerManager().SetTimerForNextTick(this, &APlayerCharacter::RefreshAbilityLevels);
+}
+
+void APlayerCharacter::RefreshAbilityLevels()
+{
+	bAbilityLevelsDirty = false;
+	for (const ECollectableType Type : FElementPocket::Elements)
+	{
+		SetAbilityLevel(Type);
+	}
+	BroadcastTankChanges();
+}
+
+void APlayerCharacter::OverloadedDrain()
+{
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_OverloadedDrain);
+
+	if (!TankComponent) return;
+	INC_DWORD_STAT(STAT_GP3_DrainEvents);
+	TankComponent->DrainEssence(TankDrainRate * DrainAggregation, bIsOverloaded);
+	UpdateOverloadDrain();
+	MarkAbilityLevelsDirty();
+}
+
+void APlayerCharacter::UpdateOverloadDrain()
+{
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (!bIsOverloaded || EssenceEntity != INDEX_NONE)
+	{
+		TimerManager.ClearTimer(OverloadDrainTimerHandle);
+	}
+	else if (!TimerManager.IsTimerActive(OverloadDrainTimerHandle))
+	{
+		TimerManager.SetTimer(OverloadDrainTimerHandle, this, &APlayerCharacter::OverloadedDrain, DrainTimer * DrainAggregation, true);
+	}
+}
+
+void APlayerCharacter::RegisterSignificance()
+{
+	USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld());
+	if (!SignificanceManager) return;
+
+	SignificanceManager->RegisterObject(this, TEXT("GP3Character"),
+		[](USignificanceManager::FManagedObjectInfo* Info, const FTransform& Viewpoint)
+		{
+			return CastChecked<APlayerCharacter>(Info->GetObject())->CalculateSignificance(Viewpoint);
+		},
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[](USignificanceManager::FManagedObjectInfo* Info, float OldSignificance, float Significance, bool bFinal)
+		{
+			if (OldSignificance != Significance)
+			{
+				CastChecked<APlayerCharacter>(Info->GetObject())->ApplySignificance(Significance);
+			}
+		});
+}
+
+void APlayerCharacter::UnregisterSignificance()
+{
+	if (USignificanceManager* SignificanceManager = FSignificanceManagerModule::Get(GetWorld()))
+	{
+		SignificanceManager->UnregisterObject(this);
+	}
+}
+
+float APlayerCharacter::CalculateSignificance(const FTransform& Viewpoint) const
+{
+	if (IsLocallyControlled()) return 1.0f;
+
+	// off screen characters count as twice as far away
+	float Distance = FVector::Dist(Viewpoint.GetLocation(), GetActorLocation());
+	if (!WasRecentlyRendered(0.2f))
+	{
+		Distance *= 2.0f;
+	}
+
+	if (Distance <= FullDetailDistance) return 1.0f;
+	if (Distance <= ReducedDetailDistance) return 0.5f;
+	return 0.0f;
+}
+
+void APlayerCharacter::ApplySignificance(float Significance)
+{
+	CurrentSignificance = Significance;
+
+	const bool bIsFullDetail = Significance >= 1.0f;
+	const bool bIsLowDetail = Significance <= 0.0f;
+
+	UpdateTickEnabled();
+
+	// montages keep ticking off screen, combo and hit windows are driven by their notifies
+	USkeletalMeshComponent* CharacterMesh = GetMesh();
+	CharacterMesh->bEnableUpdateRateOptimizations = !bIsFullDetail;
+	CharacterMesh->VisibilityBasedAnimTickOption = bIsFullDetail
+		? EVisibilityBasedAnimTickOption::AlwaysTickPoseAndRefreshBones
+		: EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+
+	const int NewDrainAggregation = bIsLowDetail ? FMath::Max(LowDrainAggregation, 1) : 1;
+	if (NewDrainAggregation == DrainAggregation) return;
+	DrainAggregation = NewDrainAggregation;
+
+	// carry the elapsed time over so switching tiers neither skips nor delays a drain
+	FTimerManager& TimerManager = GetWorldTimerManager();
+	if (TimerManager.IsTimerActive(OverloadDrainTimerHandle))
+	{
+		const float Elapsed = TimerManager.GetTimerElapsed(OverloadDrainTimerHandle);
+		const float Period = DrainTimer * DrainAggregation;
+		TimerManager.SetTimer(OverloadDrainTimerHandle, this, &APlayerCharacter::OverloadedDrain, Period, true, FMath::Max(Period - Elapsed, KINDA_SMALL_NUMBER));
+	}
+}
+
+void APlayerCharacter::HandleQuestTank(ECollectableType Type, int Value)
+{
+	if (Value <= 0) return;
+	if (EssenceEntity != INDEX_NONE)
+	{
+		EssenceSimulation->GetSimulation().RemoveFromPocket(EssenceEntity, FElementPocket::ToIndex(Type), Value);
+		return;
+	}
+	Pocket.Remove(Type, Value);
+	NotifyPocketChanged();
+}
+
+EAbilityLevel* APlayerCharacter::FindAbilityLevel(ECollectableType Type)
+{
 	switch (Type)
 	{
 	case ECollectableType::ECT_Earth:
-		CurrentStormLevel = TankComponent->CheckTypeLevel(ECollectableType::ECT_Earth);
-		break;
+		return &CurrentStormLevel;
 	case ECollectableType::ECT_Wind:
-		CurrentWindLevel = TankComponent->CheckTypeLevel(ECollectableType::ECT_Wind);
-		break;
+		return &CurrentWindLevel;
 	case ECollectableType::ECT_Fire:
-		CurrentFireLevel = TankComponent->CheckTypeLevel(ECollectableType::ECT_Fire);
-		break;
+		return &CurrentFireLevel;
 	default:
-		break;
+		return nullptr;
 	}
 }
 
-void APlayerCharacter::OverloadedDrain()
+EAbilityLevel APlayerCharacter::GetAbilityLevel(ECollectableType Type) const
 {
-	if (!TankComponent) return;
-	Timer += GetWorld()->GetDeltaSeconds();
-	if (Timer >= DrainTimer)
+	switch (Type)
 	{
-		TankComponent->DrainEssence(TankDrainRate, bIsOverloaded);
-		Timer = 0;
+	case ECollectableType::ECT_Earth:
+		return CurrentStormLevel;
+	case ECollectableType::ECT_Wind:
+		return CurrentWindLevel;
+	case ECollectableType::ECT_Fire:
+		return CurrentFireLevel;
+	default:
+		return EAbilityLevel::EAL_Level0;
 	}
 }
 
-void APlayerCharacter::HandleQuestTank(ECollectableType Type, int Value, bool bTankFull)
+void APlayerCharacter::StartTankTransfer(ECollectableType Type)
+{
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_StartTankTransfer);
+
+	if (EssenceEntity != INDEX_NONE)
+	{
+		EssenceSimulation->GetSimulation().StartTransfer(EssenceEntity, FElementPocket::ToIndex(Type));
+		return;
+	}
+
+	if (!TankComponent || GetPocketAmount(Type) <= 0) return;
+
+	// switching element mid-hold commits what the previous one accumulated
+	EndTankTransfer();
+
+	bIsTransferring = true;
+	TransferType = Type;
+	PendingTransfer = 0.0f;
+	UpdateTickEnabled();
+}
+
+int APlayerCharacter::AddToTank(ECollectableType Type, int Amount, bool& bTankFull)
+{
+	const int Space = GetTankSpace(TankComponent, Type);
+	const int Accepted = FMath::Min(Amount, Space);
+	if (Accepted > 0)
+	{
+		TankComponent->AddEssence(Type, Accepted, bTankFull);
+	}
+	bTankFull = Accepted >= Space;
+	return Accepted;
+}
+
+bool APlayerCharacter::CrossesLevelThreshold(int OldAmount, int NewAmount) const
+{
+	const int Low = FMath::Min(OldAmount, NewAmount);
+	const int High = FMath::Max(OldAmount, NewAmount);
+	for (const int Threshold : TankComponent->GetLevelThresholds())
+	{
+		if (Low < Threshold && Threshold <= High) return true;
+	}
+	return false;
+}
+
+void APlayerCharacter::CommitTankTransfer()
+{
+	GP3_SCOPE_CYCLE_COUNTER(STAT_GP3_CommitTankTransfer);
+	GP3_BENCHMARK_SCOPE("CommitTankTransfer");
+
+	const int Amount = FMath::Min(FMath::FloorToInt(PendingTransfer), GetPocketAmount(TransferType));
+	if (Amount <= 0)
+	{
+		if (GetPocketAmount(TransferType) <= 0)
+		{
+			bIsTransferring = false;
+			UpdateTickEnabled();
+		}
+		return;
+	}
+
+	// clients only predict the pocket, the tank and levels are written by the server
+	// and a wrong guess is corrected when the transfer ends
+	bool bTankFull = false;
+	const int OldTankAmount = HasAuthority() ? TankComponent->GetTypeAmount(TransferType) : 0;
+	const int Accepted = HasAuthority() ? AddToTank(TransferType, Amount, bTankFull) : Amount;
+	INC_DWORD_STAT(STAT_GP3_TankTransfers);
+	INC_DWORD_STAT_BY(STAT_GP3_EssenceTransferred, Accepted);
+	PendingTransfer -= Amount;
+	HandleQuestTank(TransferType, Accepted);
+
+	if (HasAuthority())
+	{
+		// most ticks stay inside one level band, CheckTypeLevel only runs when a threshold is crossed
+		if (CrossesLevelThreshold(OldTankAmount, OldTankAmount + Accepted))
+		{
+			SetAbilityLevel(TransferType);
+		}
+		BroadcastTankChanges();
+	}
+
+	if (bTankFull || GetPocketAmount(TransferType) <= 0)
+	{
+		bIsTransferring = false;
+		UpdateTickEnabled();
+	}
+}
+
+void APlayerCharacter::EndTankTransfer()
+{
+	if (EssenceEntity != INDEX_NONE)
+	{
+		EssenceSimulation->GetSimulation().StopTransfer(EssenceEntity);
+		return;
+	}
+
+	if (!bIsTransferring) return;
+
+	CommitTankTransfer();
+
+	bIsTransferring = false;
+	PendingTransfer = 0.0f;
+	UpdateTickEnabled();
+}
+
+void APlayerCharacter::RequestTankTransfer(ECollectableType Type)
+{
+	if (Replay)
+	{
+		Replay->RecordTransferStart(this, Type);
+	}
+
+	StartTankTransfer(Type);
+	if (!HasAuthority())
+	{
+		ServerStartTankTransfer(Type);
+	}
+}
+
+void APlayerCharacter::ServerStartTankTransfer_Implementation(ECollectableType Type)
+{
+	if (FElementPocket::ToIndex(Type) == INDEX_NONE) return;
+	StartTankTransfer(Type);
+}
+
+void APlayerCharacter::ServerEndTankTransfer_Implementation()
+{
+	EndTankTransfer();
+
+	// the pocket may not have changed on the server since it last replicated, so a
+	// client that predicted more than the tank took would never hear about it
+	ClientSyncPocket(Pocket);
+}
+
+void APlayerCharacter::ClientSyncPocket_Implementation(const FElementPocket& ServerPocket)
+{
+	FMemory::Memcpy(Pocket.Count, ServerPocket.Count, sizeof(Pocket.Count));
+	BroadcastPocketChanges();
+}
+
+void APlayerCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(APlayerCharacter, Pocket, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APlayerCharacter, CurrentStormLevel, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APlayerCharacter, CurrentWindLevel, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(APlayerCharacter, CurrentFireLevel, Params);
+}
+
+void APlayerCharacter::NotifyPocketChanged()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, Pocket, this);
+	BroadcastPocketChanges();
+}
+
+void APlayerCharacter::BroadcastPocketChanges()
+{
+	for (int32 Index = 0; Index < FElementPocket::NumElements; ++Index)
+	{
+		if (Pocket.Count[Index] == BroadcastPocketCount[Index]) continue;
+
+		BroadcastPocketCount[Index] = Pocket.Count[Index];
+		const ECollectableType Type = FElementPocket::Elements[Index];
+		OnPocketChanged.Broadcast(Type, Pocket.GetPercentage(Type));
+	}
+}
+
+void APlayerCharacter::BroadcastTankChanges()
+{
+	for (int32 Index = 0; Index < FElementPocket::NumElements; ++Index)
+	{
+		const ECollectableType Type = FElementPocket::Elements[Index];
+		const float Percentage = GetTankPercentage(Type);
+		if (Percentage == BroadcastTankPercentage[Index]) continue;
+
+		BroadcastTankPercentage[Index] = Percentage;
+		OnTankChanged.Broadcast(Type, Percentage);
+	}
+}
+
+void APlayerCharacter::OnRep_Pocket()
+{
+	BroadcastPocketChanges();
+}
+
+void APlayerCharacter::MarkAbilityLevelNetDirty(ECollectableType Type)
 {
-	if (bTankFull) return;
 	switch (Type)
 	{
 	case ECollectableType::ECT_Earth:
-		EarthCollectCount-= Value;
+		MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, CurrentStormLevel, this);
 		break;
 	case ECollectableType::ECT_Wind:
-		WindCollectCount -= Value;
+		MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, CurrentWindLevel, this);
 		break;
 	case ECollectableType::ECT_Fire:
-		FireCollectCount -= Value;
+		MARK_PROPERTY_DIRTY_FROM_NAME(APlayerCharacter, CurrentFireLevel, this);
 		break;
 	default:
 		break;
 	}
 }
 
-int APlayerCharacter::GetPocketAmount(ECollectableType Type)
+void APlayerCharacter::OnRep_StormLevel()
+{
+	OnAbilityLevelChanged.Broadcast(ECollectableType::ECT_Earth, CurrentStormLevel);
+}
+
+void APlayerCharacter::OnRep_WindLevel()
+{
+	OnAbilityLevelChanged.Broadcast(ECollectableType::ECT_Wind, CurrentWindLevel);
+}
+
+void APlayerCharacter::OnRep_FireLevel()
+{
+	OnAbilityLevelChanged.Broadcast(ECollectableType::ECT_Fire, CurrentFireLevel);
+}
+
+void APlayerCharacter::GetRecordedActions(TArray<UInputAction*>& OutActions) const
+{
+	OutActions = { MoveAction, LookAction, JumpAction, AttackAction, DashAction, FireTransferAction, WindTransferAction,
+		StormTransferAction, TankDrainAction, QuestInteractAction };
+}
+
+const UInputAction* APlayerCharacter::GetTransferAction(ECollectableType Type) const
 {
 	switch (Type)
 	{
 	case ECollectableType::ECT_Earth:
-		return EarthCollectCount;
-		break;
+		return StormTransferAction;
 	case ECollectableType::ECT_Wind:
-		return WindCollectCount;
-		break;
+		return WindTransferAction;
 	case ECollectableType::ECT_Fire:
-		return FireCollectCount;
-		break;
+		return FireTransferAction;
 	default:
-		return 0;
-		break;
+		return nullptr;
 	}
 }
 
+float APlayerCharacter::GetTankPercentage(ECollectableType Type) const
+{
+	const int32 Element = FElementPocket::ToIndex(Type);
+	if (Element == INDEX_NONE) return 0.f;
+
+	if (EssenceEntity != INDEX_NONE)
+	{
+		const FEssenceSimulation& Simulation = EssenceSimulation->GetSimulation();
+		const int32 Capacity = Simulation.GetRules().TankCapacity[Element];
+		return Capacity > 0 ? static_cast<float>(Simulation.GetTank(EssenceEntity, Element)) / Capacity : 0.f;
+	}
+	if (!TankComponent) return 0.f;
 
+	const int Capacity = TankComponent->GetTypeCapacity(Type);
+	return Capacity > 0 ? static_cast<float>(TankComponent->GetTypeAmount(Type)) / Capacity : 0.f;
+}
 
+void APlayerCharacter::ApplyEssenceState(const FEssenceSimulation& Simulation, int32 Entity, uint8 DirtyFlags)
+{
+	if (DirtyFlags & FEssenceSimulation::Dirty_Pocket)
+	{
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+		{
+			Pocket.Count[Element] = Simulation.GetPocket(Entity, Element);
+		}
+		NotifyPocketChanged();
+	}
 
+	if (DirtyFlags & FEssenceSimulation::Dirty_Level)
+	{
+		for (int32 Element = 0; Element < FElementPocket::NumElements; ++Element)
+		{
+			const ECollectableType Type = FElementPocket::Elements[Element];
+			EAbilityLevel* Level = FindAbilityLevel(Type);
+			const EAbilityLevel NewLevel = static_cast<EAbilityLevel>(Simulation.GetLevel(Entity, Element));
+			if (!Level || *Level == NewLevel) continue;
+
+			*Level = NewLevel;
+			MarkAbilityLevelNetDirty(Type);
+			OnAbilityLevelChanged.Broadcast(Type, NewLevel);
+		}
+	}
+
+	// the simulation runs the drain itself, the character's drain timer stays off
+	bIsOverloaded = Simulation.IsOverloaded(Entity);
+
+	if (DirtyFlags & FEssenceSimulation::Dirty_Tank)
+	{
+		BroadcastTankChanges();
+	}
+}
+
+void APlayerCharacter::UpdateTickEnabled()
+{
+	SetActorTickEnabled(bIsTransferring || bIsHitWindowOpen);
+
+	// an open hit window sweeps every frame whatever the significance, or fast swings skip hits
+	const bool bIsFullRate = bIsHitWindowOpen || CurrentSignificance >= 1.0f;
+	SetActorTickInterval(bIsFullRate ? 0.0f : CurrentSignificance <= 0.0f ? LowTickInterval : ReducedTickInterval);
+}
+
+int APlayerCharacter::GetPocketAmount(ECollectableType Type)
+{
+	return Pocket.Get(Type);
+}
@@ -7,9 +7,10 @@
 #include "InputActionValue.h"
 #include "CharacterTypes.h"
 #include "Items/ItemTypes.h"
+#include "Characters/ElementPocket.h"
 #include "PlayerCharacter.generated.h"
 
-class USpringArmComponent;
+class UGP3SpringArmComponent;
 class UCameraComponent;
 class UBoxComponent;
 class UInputMappingContext;
@@ -18,6 +19,24 @@ class UAnimMontage;
 
 class UTankComponent;
 class AGP3GameModeBase;
+class UQuestTankSubsystem;
+class UGP3CooldownSubsystem;
+class UEssenceSimulationSubsystem;
+class FEssenceSimulation;
+class UGP3ReplaySubsystem;
+struct FPlayerProgress;
+
+UENUM(BlueprintType)
+enum class ECombatStance : uint8
+{
+	ECS_Exploration UMETA(DisplayName = "Exploration"),
+	ECS_Combat UMETA(DisplayName = "Combat")
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAbilityLevelChanged, ECollectableType, Type, EAbilityLevel, NewLevel);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnPocketChanged, ECollectableType, Type, float, Percentage);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnTankChanged, ECollectableType, Type, float, Percentage);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnMeleeHit, AActor*, HitActor, const FHitResult&, Hit);
 
 UCLASS()
 class GP3_TEAM4_API APlayerCharacter : public ACharacter
@@ -26,21 +45,69 @@ class GP3_TEAM4_API APlayerCharacter : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	APlayerCharacter();
+	APlayerCharacter(const FObjectInitializer& ObjectInitializer);
 
 	virtual void Tick(float DeltaTime) override;
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	UFUNCTION(BlueprintCallable)
 	void GotCollectable(ECollectableType CollectableType, int CollectValue, bool& bIsCollectSuccess);
 
+	// Bulk version for the collectable pool's per-frame pickup pass, one value per pocket slot
+	void GotCollectables(const int32 (&Values)[FElementPocket::NumElements]);
+
+	const FElementPocket& GetPocket() const { return Pocket; }
+
+	float GetPickupRadius() const { return PickupRadius; }
+
+	// Input actions the replay subsystem records and plays back
+	void GetRecordedActions(TArray<UInputAction*>& OutActions) const;
+
+	// Input actions the gameplay benchmark drives, null until a Blueprint assigns them
+	const UInputAction* GetMoveAction() const { return MoveAction; }
+	const UInputAction* GetLookAction() const { return LookAction; }
+	const UInputAction* GetAttackAction() const { return AttackAction; }
+	const UInputAction* GetDashAction() const { return DashAction; }
+	const UInputAction* GetQuestInteractAction() const { return QuestInteractAction; }
+	const UInputAction* GetTransferAction(ECollectableType Type) const;
+
+	virtual void PostInitializeComponents() override;
+
+	// Possession can come after BeginPlay, e.g. pawns spawned and possessed by the benchmark
+	virtual void PawnClientRestart() override;
+
+	// Tank fill of the element from 0 to 1, from the essence simulation while it owns the tank
+	UFUNCTION(BlueprintCallable)
+	float GetTankPercentage(ECollectableType Type) const;
+
+	// Copies what the essence simulation changed for this character's entity
+	void ApplyEssenceState(const FEssenceSimulation& Simulation, int32 Entity, uint8 DirtyFlags);
+
 	UFUNCTION(BlueprintCallable)
 	EActionState GetState() { return ActionState; }
 
+	// Re-reads the element's level from the tank, broadcasting OnAbilityLevelChanged if it moved
 	UFUNCTION(BlueprintCallable)
 	void SetAbilityLevel(ECollectableType Type);
 
+	UPROPERTY(BlueprintAssignable)
+	FOnAbilityLevelChanged OnAbilityLevelChanged;
+
+	// Fires for each element whose pocket amount changed, with the new fill from 0 to 1
+	UPROPERTY(BlueprintAssignable)
+	FOnPocketChanged OnPocketChanged;
+
+	// Fires for each element whose tank fill changed, with the new fill from 0 to 1
+	UPROPERTY(BlueprintAssignable)
+	FOnTankChanged OnTankChanged;
+
+	// Fires once per target per swing while a hit window is open, alongside AttackCollision's own overlap events
+	UPROPERTY(BlueprintAssignable)
+	FOnMeleeHit OnMeleeHit;
+
 	UFUNCTION(BlueprintCallable)
 	EAbilityLevel GetStormLevel() { return CurrentStormLevel; }
 
@@ -50,6 +117,8 @@ public:
 	UFUNCTION(BlueprintCallable)
 	EAbilityLevel GetFireLevel() { return CurrentFireLevel; }
 
+	EAbilityLevel GetAbilityLevel(ECollectableType Type) const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gameplay")
 	bool bCanMove = true;
 
@@ -62,12 +131,19 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	float StrafeMoveSpeed = 400.f;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Camera)
+	float CombatArmLength = 600.f;
+
+	// Applies rotation mode, walk speed and camera settings for the stance, only when it changes
+	UFUNCTION(BlueprintCallable)
+	void SetStance(ECombatStance NewStance);
+
+	UFUNCTION(BlueprintCallable)
+	ECombatStance GetStance() const { return Stance; }
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gameplay")
 	float CombatExpirationTime = 1.f;
 
-	UPROPERTY()
-	FTimerHandle CombatTimerHandle;
-
 	UFUNCTION()
 	void StartCombatTimer();
 	
@@ -89,9 +165,6 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Gameplay")
 	bool bIsDashing = false;
 
-	UPROPERTY()
-	FTimerHandle DashCooldownTimerHandle;
-
 	UFUNCTION()
 	void StartDashCooldownTimer();
 	
@@ -101,9 +174,6 @@ public:
 	UFUNCTION()
 	void OnDashCooldownTimerExpired();
 
-	UPROPERTY()
-	FTimerHandle DashTimerHandle;
-
 	UFUNCTION()
 	void StartDashTimer();
 	
@@ -116,11 +186,24 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void ResetDash();
 
+	// Pocket, tank and ability state saved with checkpoints
+	void CaptureProgress(FPlayerProgress& OutProgress) const;
+	void RestoreProgress(const FPlayerProgress& Progress);
+
+	// Resets combat, dash and transfer state, restores the snapshot and teleports the pawn,
+	// reusing everything BeginPlay already set up instead of spawning a new character
+	void RespawnInPlace(const FVector& Location, const FPlayerProgress& Progress);
+
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Adds GroundMappingContext for a locally controlled pawn
+	void AddGroundMappingContext();
+
 	// Called for movement input 
 	void Move(const FInputActionValue& Value);
 	void Dash();
@@ -138,6 +221,8 @@ protected:
 
 	void FireTankTranfer(const FInputActionValue& Value);
 
+	void StopTankTransfer(const FInputActionValue& Value);
+
 	void TankDrainPressed(const FInputActionValue& Value);
 
 	void QuestTankTransfer(const FInputActionValue& Value);
@@ -145,6 +230,12 @@ protected:
 	//Combat Input
 	void AttackSequence();
 
+	// Starts the next combo step, returns false if the current state doesn't allow it
+	bool TryAttack();
+
+	// Runs an attack pressed within AttackBufferTime of the combo window opening
+	void ConsumeBufferedAttack();
+
 	UFUNCTION(BlueprintCallable)
 	void CanAttack();
 
@@ -152,6 +243,12 @@ protected:
 	void AttackEnd();
 	UFUNCTION(BlueprintCallable)
 	void Hitting();
+
+	// Hit windows are opened and closed by anim notifies, AttackCollision is swept along its path while open
+	UFUNCTION(BlueprintCallable)
+	void OpenHitWindow();
+	UFUNCTION(BlueprintCallable)
+	void CloseHitWindow();
 	UFUNCTION(BlueprintCallable)
 	void Dashing();
 
@@ -159,11 +256,11 @@ protected:
 	void HeavyAttack();
 
 	UFUNCTION(BlueprintCallable)
-	float GetEarthCollectPercengate() {return (float)EarthCollectCount/ (float)EarthMaxAmmount;}
+	float GetEarthCollectPercengate() { return Pocket.GetPercentage(ECollectableType::ECT_Earth); }
 	UFUNCTION(BlueprintCallable)
-	float GetWindCollectPercengate() {return (float)FireCollectCount / (float)FireMaxAmmount;}
+	float GetWindCollectPercengate() { return Pocket.GetPercentage(ECollectableType::ECT_Wind); }
 	UFUNCTION(BlueprintCallable)
-	float GetFireCollectPercengate() { return (float)WindCollectCount / (float)WindMaxAmmount; }
+	float GetFireCollectPercengate() { return Pocket.GetPercentage(ECollectableType::ECT_Fire); }
 
 
 
@@ -171,12 +268,86 @@ private:
 
 	void OverloadedDrain();
 
-	void HandleQuestTank(ECollectableType Type, int Value ,bool bTankFull);
+	// Starts or stops the drain timer to match bIsOverloaded
+	void UpdateOverloadDrain();
+
+	// removes what the quest tank or player tank actually accepted from the pocket
+	void HandleQuestTank(ECollectableType Type, int Value);
+
+	// batched AddEssence clamped to the tank's free space, returns how many units it accepted
+	int AddToTank(ECollectableType Type, int Amount, bool& bTankFull);
+
+	// True if a level threshold of the tank lies between the two amounts
+	bool CrossesLevelThreshold(int OldAmount, int NewAmount) const;
 
 	int GetPocketAmount(ECollectableType Type);
 
+	EAbilityLevel* FindAbilityLevel(ECollectableType Type);
+
+	// Coalesces level checks after tank changes into one refresh on the next tick
+	void MarkAbilityLevelsDirty();
+	void RefreshAbilityLevels();
+
+	// Held transfers accumulate flow every tick and hand it to the tank in whole units
+	void StartTankTransfer(ECollectableType Type);
+	void CommitTankTransfer();
+	void EndTankTransfer();
+
+	// Transfers run on the server, owning clients predict them locally until the pocket replicates back
+	void RequestTankTransfer(ECollectableType Type);
+	UFUNCTION(Server, Reliable)
+	void ServerStartTankTransfer(ECollectableType Type);
+	UFUNCTION(Server, Reliable)
+	void ServerEndTankTransfer();
+
+	UFUNCTION(Server, Reliable)
+	void ServerQuestTankTransfer();
+
+	// Returns false if nothing went into the quest tank
+	bool TransferToQuestTank();
+	UTankComponent* FindQuestTank();
+
+	// Corrects a predicted pocket the server's values never diverged from in replication
+	UFUNCTION(Client, Reliable)
+	void ClientSyncPocket(const FElementPocket& ServerPocket);
+
+	// Push model: replicated state only gets compared after one of these.
+	// The pocket one also broadcasts OnPocketChanged for the elements that moved
+	void NotifyPocketChanged();
+	void MarkAbilityLevelNetDirty(ECollectableType Type);
+
+	void BroadcastPocketChanges();
+
+	// Broadcasts OnTankChanged for the elements whose tank fill moved since the last call
+	void BroadcastTankChanges();
+
+	UFUNCTION()
+	void OnRep_Pocket();
+	UFUNCTION()
+	void OnRep_StormLevel();
+	UFUNCTION()
+	void OnRep_WindLevel();
+	UFUNCTION()
+	void OnRep_FireLevel();
+
+	// Significance manager hooks, 1 keeps full fidelity, 0.5 reduced and 0 the cheapest settings
+	void RegisterSignificance();
+	void UnregisterSignificance();
+	float CalculateSignificance(const FTransform& Viewpoint) const;
+	void ApplySignificance(float Significance);
+
+	// Enables ticking while there is per-frame work and picks the interval for the significance tier
+	void UpdateTickEnabled();
+
+	// Look input is summed as it arrives and applied once per frame after all actors have ticked
+	void ApplyLateLook(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	// Issues an async sweep of AttackCollision from where it was last frame to where it is now
+	void TraceMeleeSwing();
+	void OnMeleeTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
 	UPROPERTY(EditAnywhere,BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess= "true"))
-	USpringArmComponent* CameraBoom;
+	UGP3SpringArmComponent* CameraBoom;
 	 
 	UPROPERTY(EditAnywhere, Category = Camera)
 	UCameraComponent* FollowCamera;
@@ -184,6 +355,14 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Combat , meta = (AllowPrivateAccess = "true"))
 	UBoxComponent* AttackCollision;
 
+	// Mesh socket AttackCollision follows so melee sweeps trace the weapon, None keeps it on the capsule
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	FName AttackSocketName;
+
+	// Object type melee sweeps look for
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	TEnumAsByte<ECollisionChannel> MeleeHitObjectChannel = ECC_GameTraceChannel2;
+
 	UPROPERTY(EditAnywhere, Category = Input)
 	UInputMappingContext* GroundMappingContext;
 
@@ -219,8 +398,9 @@ private:
 	
 
 
+	// Distance covered over DashDuration
 	UPROPERTY(EditAnywhere, Category = Input)
-	float DashDistance = 1000.f;
+	float DashDistance = 400.f;
 
 	UPROPERTY(EditAnywhere, Category = Input)
 	FVector2D MoveAxisVector;
@@ -228,42 +408,107 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category = Montages)
 	UAnimMontage* AttackMontage;
 
+	// Montage section for each combo step, None plays the montage from the start
+	UPROPERTY(EditDefaultsOnly, Category = Montages)
+	TArray<FName> ComboSections;
+
+	// How long an attack press is kept while the current swing can't be cancelled yet
+	UPROPERTY(EditDefaultsOnly, Category = Combat)
+	float AttackBufferTime = 0.2f;
+
 	UPROPERTY(BlueprintReadWrite, meta =(AllowPrivateAccess ="true"))
 	EActionState ActionState = EActionState::EAS_Unoccupied;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	ECombatStance Stance = ECombatStance::ECS_Exploration;
+
+	float ExplorationArmLength = 600.f;
+
 	UTankComponent* TankComponent;
 
-	UPROPERTY(EditDefaultsOnly, Category = Collect)
-	int EarthMaxAmmount = 100;
-	UPROPERTY(EditDefaultsOnly, Category = Collect)
-	int FireMaxAmmount = 100;
-	UPROPERTY(EditDefaultsOnly, Category = Collect)
-	int WindMaxAmmount = 100;
+	UPROPERTY(EditDefaultsOnly, ReplicatedUsing = OnRep_Pocket, Category = Collect)
+	FElementPocket Pocket;
+
+	// Pocket counts listeners were last told about
+	int32 BroadcastPocketCount[FElementPocket::NumElements] = {};
+
+	// Tank fills listeners were last told about
+	float BroadcastTankPercentage[FElementPocket::NumElements] = {};
 	UPROPERTY(EditDefaultsOnly, Category = Collect)
 	int TankFlowRate = 1;
+	// Units per second moved from a pocket into the tank while a transfer input is held
+	UPROPERTY(EditDefaultsOnly, Category = Collect)
+	float TankTransferRate = 60.0f;
 	UPROPERTY(EditDefaultsOnly, Category = Collect)
 	int TankDrainRate = 1;
 	UPROPERTY(EditDefaultsOnly, Category = Collect)
 	float DrainTimer = 2.0f;
 
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+	float FullDetailDistance = 1500.0f;
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+	float ReducedDetailDistance = 4000.0f;
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+	float ReducedTickInterval = 0.05f;
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+	float LowTickInterval = 0.2f;
+	// Low significance characters drain this many steps at once on a timer that much longer
+	UPROPERTY(EditDefaultsOnly, Category = Significance)
+	int LowDrainAggregation = 4;
+
 	UPROPERTY(EditDefaultsOnly, Category = Collect)
 	float MaximumInteractionRange = 200.0f;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta= (AllowPrivateAccess ="true"))
+	// Hands pocket, transfer, drain and overload rules to the essence simulation subsystem on the server,
+	// with the tank component's capacities and thresholds. The tank component is left untouched while this is on
+	UPROPERTY(EditDefaultsOnly, Category = Collect)
+	bool bSimulateEssence = false;
+
+	// Pooled collectables inside this radius are picked up automatically
+	UPROPERTY(EditDefaultsOnly, Category = Collect)
+	float PickupRadius = 150.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_FireLevel, meta= (AllowPrivateAccess ="true"))
 	EAbilityLevel CurrentFireLevel = EAbilityLevel::EAL_Level0;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta= (AllowPrivateAccess ="true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_StormLevel, meta= (AllowPrivateAccess ="true"))
 	EAbilityLevel CurrentStormLevel = EAbilityLevel::EAL_Level0;
 	
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta= (AllowPrivateAccess ="true"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_WindLevel, meta= (AllowPrivateAccess ="true"))
 	EAbilityLevel CurrentWindLevel = EAbilityLevel::EAL_Level0;
 
 	int ComboCount = 0;
-	int EarthCollectCount = 0;
-	int FireCollectCount = 0;
-	int WindCollectCount = 0;
-	float Timer = 0.0f;
+	double BufferedAttackTime = -1.0;
 	bool bIsOverloaded = false;
 
+	bool bAbilityLevelsDirty = false;
+
+	bool bIsHitWindowOpen = false;
+	uint32 SwingId = 0;
+	FVector LastSwingLocation;
+	TSet<TWeakObjectPtr<AActor>> HitActorsThisSwing;
+	FTraceDelegate MeleeTraceDelegate;
+
+	bool bIsTransferring = false;
+	ECollectableType TransferType = ECollectableType::ECT_Earth;
+	float PendingTransfer = 0.0f;
+
+	FTimerHandle OverloadDrainTimerHandle;
+
+	FVector2D PendingLook = FVector2D::ZeroVector;
+	uint64 PendingLookCycles = 0;
+	FDelegateHandle LateLookHandle;
+	int DrainAggregation = 1;
+	float CurrentSignificance = 1.0f;
+
 	AGP3GameModeBase* GameMode;
+
+	UQuestTankSubsystem* QuestTankSubsystem;
+
+	UGP3CooldownSubsystem* Cooldowns;
+
+	UEssenceSimulationSubsystem* EssenceSimulation;
+
+	UGP3ReplaySubsystem* Replay;
+	int32 EssenceEntity = INDEX_NONE;
 };
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameMode/QuestTankSubsystem.h"
+#include "Characters/Components/TankComponent.h"
+#include "GP3Log.h"
+
+void UQuestTankSubsystem::RegisterQuestTank(AActor* QuestTank)
+{
+	if (!QuestTank) return;
+
+	UnregisterQuestTank(QuestTank);
+
+	UTankComponent* QuestTankComponent = QuestTank->FindComponentByClass<UTankComponent>();
+	if (!QuestTankComponent)
+	{
+		GP3_LOG(Warning, TEXT("Quest tank %s has no tank Component"), *QuestTank->GetName());
+		return;
+	}
+
+	FQuestTankEntry Entry;
+	Entry.Actor = QuestTank;
+	Entry.TankComponent = QuestTankComponent;
+	Entry.Location = QuestTank->GetActorLocation();
+	Entry.Cell = GetCell(Entry.Location);
+
+	const int32 Index = Entries.Add(Entry);
+	Cells.FindOrAdd(Entry.Cell).Add(Index);
+	EntryIndexByActor.Add(QuestTank, Index);
+}
+
+void UQuestTankSubsystem::UnregisterQuestTank(AActor* QuestTank)
+{
+	int32 Index;
+	if (!EntryIndexByActor.RemoveAndCopyValue(QuestTank, Index)) return;
+
+	const FIntVector Cell = Entries[Index].Cell;
+	if (TArray<int32>* CellEntries = Cells.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(Index);
+		if (CellEntries->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+	Entries.RemoveAt(Index);
+}
+
+UTankComponent* UQuestTankSubsystem::FindClosestQuestTank(const FVector& Location, float MaxRange, float& OutDistance) const
+{
+	const FIntVector MinCell = GetCell(Location - FVector(MaxRange));
+	const FIntVector MaxCell = GetCell(Location + FVector(MaxRange));
+
+	UTankComponent* ClosestTank = nullptr;
+	float ClosestDistanceSquared = FMath::Square(MaxRange);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z)
+			{
+				const TArray<int32>* CellEntries = Cells.Find(FIntVector(X, Y, Z));
+				if (!CellEntries) continue;
+
+				for (const int32 Index : *CellEntries)
+				{
+					const FQuestTankEntry& Entry = Entries[Index];
+					const float DistanceSquared = FVector::DistSquared(Location, Entry.Location);
+					if (DistanceSquared < ClosestDistanceSquared)
+					{
+						if (UTankComponent* QuestTankComponent = Entry.TankComponent.Get())
+						{
+							ClosestTank = QuestTankComponent;
+							ClosestDistanceSquared = DistanceSquared;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	OutDistance = ClosestTank ? FMath::Sqrt(ClosestDistanceSquared) : MaxRange;
+	return ClosestTank;
+}
+
+void UQuestTankSubsystem::Deinitialize()
+{
+	Entries.Empty();
+	Cells.Empty();
+	EntryIndexByActor.Empty();
+
+	Super::Deinitialize();
+}
+
+FIntVector UQuestTankSubsystem::GetCell(const FVector& Location) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
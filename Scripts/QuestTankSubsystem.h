@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "QuestTankSubsystem.generated.h"
+
+class UTankComponent;
+
+/**
+ * Uniform grid of the quest tanks in the world, so interaction lookups only
+ * visit the cells around the player instead of every tank in the level.
+ * Quest tanks are static: a tank that moves has to register again.
+ */
+UCLASS()
+class GP3_TEAM4_API UQuestTankSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UFUNCTION(BlueprintCallable)
+	void RegisterQuestTank(AActor* QuestTank);
+
+	UFUNCTION(BlueprintCallable)
+	void UnregisterQuestTank(AActor* QuestTank);
+
+	// Returns the tank component of the closest registered quest tank within MaxRange, or nullptr
+	UTankComponent* FindClosestQuestTank(const FVector& Location, float MaxRange, float& OutDistance) const;
+
+	bool HasQuestTanks() const { return EntryIndexByActor.Num() > 0; }
+
+	virtual void Deinitialize() override;
+
+private:
+
+	struct FQuestTankEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TWeakObjectPtr<UTankComponent> TankComponent;
+		FVector Location;
+		FIntVector Cell;
+	};
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	// Should be at least MaximumInteractionRange so a query touches a handful of cells
+	float CellSize = 500.f;
+
+	TSparseArray<FQuestTankEntry> Entries;
+
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	TMap<TObjectKey<AActor>, int32> EntryIndexByActor;
+};